@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Ammo.h"
+#include "AmmoStackSubsystem.h"
+#include "Engine/World.h"
+
+AAmmo::AAmmo() :
+	AmmoType(EAmmoType::EAT_9mm)
+{
+	SetItemCount(30);
+}
+
+void AAmmo::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UAmmoStackSubsystem* AmmoStacks = GetWorld()->GetSubsystem<UAmmoStackSubsystem>())
+	{
+		AmmoStacks->RemoveAmmo(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AAmmo::OnItemStateChanged()
+{
+	Super::OnItemStateChanged();
+
+	if (UAmmoStackSubsystem* AmmoStacks = GetWorld()->GetSubsystem<UAmmoStackSubsystem>())
+	{
+		AmmoStacks->UpdateAmmo(this);
+	}
+}
+
+void AAmmo::ResetPooledItem()
+{
+	SetItemCount(GetDefault<AAmmo>(GetClass())->GetItemCount());
+
+	Super::ResetPooledItem();
+}
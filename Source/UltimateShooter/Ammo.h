@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Item.h"
+#include "AmmoType.h"
+#include "Ammo.generated.h"
+
+/**
+ * Box of ammo lying in the world, ItemCount rounds of AmmoType are added to the character's ammo on pickup.
+ * Boxes of the same type that come to rest close to each other are merged by UAmmoStackSubsystem
+ */
+UCLASS()
+class ULTIMATESHOOTER_API AAmmo : public AItem
+{
+	GENERATED_BODY()
+
+public:
+	AAmmo();
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Hands the box to UAmmoStackSubsystem to merge once it lies in the pickup state */
+	virtual void OnItemStateChanged() override;
+
+private:
+	/* Type of ammo the box holds */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ammo Properties", meta = (AllowPrivateAccess = "true"))
+	EAmmoType AmmoType;
+
+public:
+	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
+
+	/* Back to the class default count, merges grow boxes before they return to the pool */
+	virtual void ResetPooledItem() override;
+};
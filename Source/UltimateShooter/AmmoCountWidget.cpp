@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AmmoCountWidget.h"
+#include "ShooterCharacter.h"
+#include "Weapon.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/TextBlock.h"
+#include "GameFramework/PlayerController.h"
+
+TSharedRef<SWidget> UAmmoCountWidget::RebuildWidget()
+{
+	// A Blueprint layout shows the counts itself
+	if (WidgetTree == nullptr || WidgetTree->RootWidget) return Super::RebuildWidget();
+
+	DefaultAmmoText = WidgetTree->ConstructWidget<UTextBlock>(UTextBlock::StaticClass(), TEXT("AmmoText"));
+	DefaultAmmoText->SetShadowOffset(FVector2D(1.f, 1.f));
+	DefaultAmmoText->SetShadowColorAndOpacity(FLinearColor(0.f, 0.f, 0.f, 0.8f));
+	WidgetTree->RootWidget = DefaultAmmoText;
+	RefreshDefaultLayout();
+
+	return Super::RebuildWidget();
+}
+
+void UAmmoCountWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	if (APlayerController* PlayerController = GetOwningPlayer())
+	{
+		NewPawnHandle = PlayerController->GetOnNewPawnNotifier().AddUObject(this, &UAmmoCountWidget::SetCharacter);
+		SetCharacter(PlayerController->GetPawn());
+	}
+}
+
+void UAmmoCountWidget::NativeDestruct()
+{
+	if (APlayerController* PlayerController = GetOwningPlayer())
+	{
+		PlayerController->GetOnNewPawnNotifier().Remove(NewPawnHandle);
+	}
+	NewPawnHandle.Reset();
+	SetCharacter(nullptr);
+	bHasRefreshed = false;
+
+	Super::NativeDestruct();
+}
+
+void UAmmoCountWidget::SetCharacter(APawn* Pawn)
+{
+	if (AShooterCharacter* OldCharacter = Character.Get())
+	{
+		OldCharacter->OnEquipedWeaponChanged().Remove(EquipedWeaponChangedHandle);
+		OldCharacter->OnCarriedAmmoChanged().Remove(CarriedAmmoChangedHandle);
+	}
+	EquipedWeaponChangedHandle.Reset();
+	CarriedAmmoChangedHandle.Reset();
+
+	Character = Cast<AShooterCharacter>(Pawn);
+	if (AShooterCharacter* NewCharacter = Character.Get())
+	{
+		EquipedWeaponChangedHandle = NewCharacter->OnEquipedWeaponChanged().AddUObject(this, &UAmmoCountWidget::SetWeapon);
+		CarriedAmmoChangedHandle = NewCharacter->OnCarriedAmmoChanged().AddUObject(this, &UAmmoCountWidget::HandleCarriedAmmoChanged);
+	}
+
+	SetWeapon(Character.IsValid() ? Character->GetEquipedWeapon() : nullptr);
+}
+
+void UAmmoCountWidget::SetWeapon(AWeapon* InWeapon)
+{
+	if (AWeapon* OldWeapon = Weapon.Get())
+	{
+		OldWeapon->OnAmmoChanged().Remove(WeaponAmmoChangedHandle);
+	}
+	WeaponAmmoChangedHandle.Reset();
+
+	Weapon = InWeapon;
+	if (InWeapon)
+	{
+		WeaponAmmoChangedHandle = InWeapon->OnAmmoChanged().AddUObject(this, &UAmmoCountWidget::HandleWeaponAmmoChanged);
+	}
+
+	Refresh();
+}
+
+void UAmmoCountWidget::HandleCarriedAmmoChanged(EAmmoType ChangedAmmoType, int32 Count)
+{
+	// Ammo of other types isn't shown
+	if (bHasWeapon && ChangedAmmoType == AmmoType)
+	{
+		Refresh();
+	}
+}
+
+void UAmmoCountWidget::HandleWeaponAmmoChanged(AWeapon* ChangedWeapon)
+{
+	Refresh();
+}
+
+void UAmmoCountWidget::Refresh()
+{
+	const AWeapon* CurrentWeapon = Weapon.Get();
+	const AShooterCharacter* CurrentCharacter = Character.Get();
+
+	const bool bNewHasWeapon = CurrentWeapon != nullptr;
+	const int32 NewWeaponAmmo = CurrentWeapon ? CurrentWeapon->GetAmmo() : 0;
+	const int32 NewMagazineCapacity = CurrentWeapon ? CurrentWeapon->GetMagazineCapacity() : 0;
+	const EAmmoType NewAmmoType = CurrentWeapon ? CurrentWeapon->GetAmmoType() : AmmoType;
+	const int32 NewCarriedAmmo = CurrentWeapon && CurrentCharacter ? CurrentCharacter->GetCarriedAmmo(NewAmmoType) : 0;
+
+	// Events can repeat a count, e.g. a reload that found the magazine full. Nothing to repaint then
+	if (bHasRefreshed &&
+		bNewHasWeapon == bHasWeapon &&
+		NewWeaponAmmo == WeaponAmmo &&
+		NewMagazineCapacity == MagazineCapacity &&
+		NewAmmoType == AmmoType &&
+		NewCarriedAmmo == CarriedAmmo)
+	{
+		return;
+	}
+
+	bHasWeapon = bNewHasWeapon;
+	WeaponAmmo = NewWeaponAmmo;
+	MagazineCapacity = NewMagazineCapacity;
+	AmmoType = NewAmmoType;
+	CarriedAmmo = NewCarriedAmmo;
+	bHasRefreshed = true;
+	RefreshDefaultLayout();
+	OnAmmoCountChanged();
+}
+
+void UAmmoCountWidget::RefreshDefaultLayout()
+{
+	if (DefaultAmmoText == nullptr) return;
+
+	DefaultAmmoText->SetText(bHasWeapon ? FText::FromString(FString::Printf(TEXT("%d / %d"), WeaponAmmo, CarriedAmmo)) : FText::GetEmpty());
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "AmmoType.h"
+#include "AmmoCountWidget.generated.h"
+
+class AShooterCharacter;
+class AWeapon;
+class UTextBlock;
+
+/**
+ * Magazine and carried ammo of the owning player's equiped weapon. Listens to the character's and the weapon's
+ * change events instead of polling, so placed inside an invalidation box it only repaints when a count changes.
+ * Used as is, without a Blueprint layout, it builds a plain text layout of its own
+ */
+UCLASS(meta = (DisableNativeTick))
+class ULTIMATESHOOTER_API UAmmoCountWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+	/* Called when any of the properties below changed */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Ammo Count")
+	void OnAmmoCountChanged();
+
+private:
+	/* Listen to Pawn if it is a shooter character, stop listening to the previous one */
+	void SetCharacter(APawn* Pawn);
+
+	/* Listen to the equiped Weapon's magazine */
+	void SetWeapon(AWeapon* InWeapon);
+
+	void HandleCarriedAmmoChanged(EAmmoType ChangedAmmoType, int32 Count);
+	void HandleWeaponAmmoChanged(AWeapon* ChangedWeapon);
+
+	/* Copy the counts from the character and weapon, calls OnAmmoCountChanged if anything differs */
+	void Refresh();
+
+	/* Show the counts in the default layout, does nothing for Blueprints that have their own */
+	void RefreshDefaultLayout();
+
+	/* True while the character has a weapon equiped */
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Count", meta = (AllowPrivateAccess = "true"))
+	bool bHasWeapon;
+
+	/* Rounds in the equiped weapon's magazine */
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Count", meta = (AllowPrivateAccess = "true"))
+	int32 WeaponAmmo;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Count", meta = (AllowPrivateAccess = "true"))
+	int32 MagazineCapacity;
+
+	/* Rounds of the equiped weapon's ammo type carried outside the magazine */
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Count", meta = (AllowPrivateAccess = "true"))
+	int32 CarriedAmmo;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Count", meta = (AllowPrivateAccess = "true"))
+	EAmmoType AmmoType;
+
+	/* False until Refresh first called OnAmmoCountChanged, the first refresh always does */
+	bool bHasRefreshed;
+
+	TWeakObjectPtr<AShooterCharacter> Character;
+	TWeakObjectPtr<AWeapon> Weapon;
+
+	FDelegateHandle NewPawnHandle;
+	FDelegateHandle EquipedWeaponChangedHandle;
+	FDelegateHandle CarriedAmmoChangedHandle;
+	FDelegateHandle WeaponAmmoChangedHandle;
+
+	/* Text of the layout RebuildWidget builds when no Blueprint layout exists */
+	UPROPERTY(Transient)
+	UTextBlock* DefaultAmmoText;
+};
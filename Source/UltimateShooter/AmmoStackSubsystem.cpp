@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AmmoStackSubsystem.h"
+#include "UltimateShooter.h"
+#include "Ammo.h"
+#include "ItemGridSubsystem.h"
+#include "ItemPoolSubsystem.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarAmmoStackEnabled(
+	TEXT("Shooter.AmmoStack.Enabled"),
+	true,
+	TEXT("Merge ammo boxes of the same type that come to rest close to each other."));
+
+static TAutoConsoleVariable<float> CVarAmmoStackMergeRadius(
+	TEXT("Shooter.AmmoStack.MergeRadius"),
+	150.f,
+	TEXT("Distance in cm within which ammo boxes of the same type are merged."));
+
+static FAutoConsoleCommandWithWorld AmmoStackStatsCommand(
+	TEXT("Shooter.AmmoStack.Stats"),
+	TEXT("Log live ammo boxes and merge counters for the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UAmmoStackSubsystem* AmmoStacks = World ? World->GetSubsystem<UAmmoStackSubsystem>() : nullptr)
+		{
+			AmmoStacks->DumpStats();
+		}
+	}));
+
+DECLARE_CYCLE_STAT(TEXT("Ammo Stack Merge"), STAT_AmmoStackMerge, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Ammo Boxes"), STAT_LiveAmmo, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ammo Box Merges"), STAT_AmmoMerges, STATGROUP_UltimateShooter);
+
+UAmmoStackSubsystem::UAmmoStackSubsystem() :
+	PeakLiveAmmo(0),
+	NumMerges(0),
+	NumRoundsMerged(0)
+{
+}
+
+bool UAmmoStackSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAmmoStackSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_LiveAmmo, LiveAmmo.Num());
+	LiveAmmo.Empty();
+	PendingAmmo.Empty();
+
+	Super::Deinitialize();
+}
+
+void UAmmoStackSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingAmmo.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_AmmoStackMerge);
+
+	// Merging parks boxes, which takes them out of PendingAmmo while it is walked
+	TArray<AAmmo*> RestingAmmo = MoveTemp(PendingAmmo);
+
+	if (!CVarAmmoStackEnabled.GetValueOnGameThread()) return;
+
+	const float MergeRadius = CVarAmmoStackMergeRadius.GetValueOnGameThread();
+	for (AAmmo* Ammo : RestingAmmo)
+	{
+		// Absorbed or picked up by an earlier box this frame
+		if (!IsValid(Ammo) || Ammo->GetItemState() != EItemState::EIS_Pickup) continue;
+
+		MergeAmmo(Ammo, MergeRadius);
+	}
+}
+
+TStatId UAmmoStackSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAmmoStackSubsystem, STATGROUP_Tickables);
+}
+
+void UAmmoStackSubsystem::UpdateAmmo(AAmmo* Ammo)
+{
+	if (Ammo == nullptr) return;
+
+	if (Ammo->GetItemState() == EItemState::EIS_Parked)
+	{
+		RemoveAmmo(Ammo);
+		return;
+	}
+
+	bool bAlreadyLive = false;
+	LiveAmmo.Add(Ammo, &bAlreadyLive);
+	if (!bAlreadyLive)
+	{
+		INC_DWORD_STAT(STAT_LiveAmmo);
+		PeakLiveAmmo = FMath::Max(PeakLiveAmmo, LiveAmmo.Num());
+	}
+
+	if (Ammo->GetItemState() == EItemState::EIS_Pickup)
+	{
+		PendingAmmo.AddUnique(Ammo);
+	}
+	else
+	{
+		PendingAmmo.RemoveSingleSwap(Ammo, false);
+	}
+}
+
+void UAmmoStackSubsystem::RemoveAmmo(AAmmo* Ammo)
+{
+	if (LiveAmmo.Remove(Ammo) > 0)
+	{
+		DEC_DWORD_STAT(STAT_LiveAmmo);
+	}
+	PendingAmmo.RemoveSingleSwap(Ammo, false);
+}
+
+bool UAmmoStackSubsystem::MergeAmmo(AAmmo* Ammo, float MergeRadius)
+{
+	const UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>();
+	if (ItemGrid == nullptr) return false;
+
+	const FVector Location{ Ammo->GetActorLocation() };
+	NearbyItems.Reset();
+	ItemGrid->GetItemsInRange(Location, MergeRadius, NearbyItems);
+
+	// The grid reaches as far as each item's pickup radius, only boxes actually close by merge
+	AAmmo* ClosestAmmo = nullptr;
+	double ClosestDistanceSquared = FMath::Square(MergeRadius);
+	for (AItem* Item : NearbyItems)
+	{
+		AAmmo* OtherAmmo = Cast<AAmmo>(Item);
+		if (OtherAmmo == nullptr || OtherAmmo == Ammo || OtherAmmo->GetAmmoType() != Ammo->GetAmmoType()) continue;
+
+		const double DistanceSquared = FVector::DistSquared(Location, OtherAmmo->GetActorLocation());
+		if (DistanceSquared <= ClosestDistanceSquared)
+		{
+			ClosestAmmo = OtherAmmo;
+			ClosestDistanceSquared = DistanceSquared;
+		}
+	}
+	if (ClosestAmmo == nullptr) return false;
+
+	// The bigger box stays where it is, so a growing stack doesn't wander towards every new box
+	AAmmo* Target = ClosestAmmo;
+	AAmmo* Source = Ammo;
+	if (Source->GetItemCount() > Target->GetItemCount())
+	{
+		Swap(Target, Source);
+	}
+
+	Target->SetItemCount(Target->GetItemCount() + Source->GetItemCount());
+	NumRoundsMerged += Source->GetItemCount();
+	++NumMerges;
+	INC_DWORD_STAT(STAT_AmmoMerges);
+
+	UItemPoolSubsystem::DespawnItem(Source);
+	return true;
+}
+
+void UAmmoStackSubsystem::DumpStats() const
+{
+	UE_LOG(LogUltimateShooter, Log, TEXT("Ammo stacks: %d live boxes (peak %d), %d merges (%d rounds moved), %d pending, merge radius %.0f%s"),
+		LiveAmmo.Num(),
+		PeakLiveAmmo,
+		NumMerges,
+		NumRoundsMerged,
+		PendingAmmo.Num(),
+		CVarAmmoStackMergeRadius.GetValueOnGameThread(),
+		CVarAmmoStackEnabled.GetValueOnGameThread() ? TEXT("") : TEXT(" (disabled)"));
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AmmoStackSubsystem.generated.h"
+
+class AAmmo;
+
+/**
+ * Keeps long matches from piling up ammo actors. Boxes that come to rest in the pickup state are queued,
+ * and once a frame every queued box looks for a box of the same type within the merge radius in the item grid.
+ * The smaller box's count is added to the larger one and the smaller one goes back to the item pool
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UAmmoStackSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UAmmoStackSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Track Ammo as live unless it is parked, and queue it for merging if it lies in the pickup state */
+	void UpdateAmmo(AAmmo* Ammo);
+
+	/* Stop tracking Ammo */
+	void RemoveAmmo(AAmmo* Ammo);
+
+	/* Log live ammo and merge counters */
+	void DumpStats() const;
+
+private:
+	/* Merge Ammo into, or absorb, the closest box of its type within the merge radius. True if a merge happened */
+	bool MergeAmmo(AAmmo* Ammo, float MergeRadius);
+
+	/* Boxes that came to rest since the last tick */
+	UPROPERTY()
+	TArray<AAmmo*> PendingAmmo;
+
+	/* Boxes out of the item pool, lying around or being picked up */
+	TSet<const AAmmo*> LiveAmmo;
+
+	/* Most boxes live at once */
+	int32 PeakLiveAmmo;
+
+	/* Boxes merged away */
+	int32 NumMerges;
+
+	/* Rounds moved from a merged box to the one that absorbed it */
+	int32 NumRoundsMerged;
+
+	/* Scratch result of the item grid query */
+	TArray<class AItem*> NearbyItems;
+
+public:
+	FORCEINLINE int32 GetNumLiveAmmo() const { return LiveAmmo.Num(); }
+	FORCEINLINE int32 GetPeakLiveAmmo() const { return PeakLiveAmmo; }
+	FORCEINLINE int32 GetNumMerges() const { return NumMerges; }
+};
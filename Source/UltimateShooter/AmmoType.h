@@ -5,6 +5,7 @@ enum class EAmmoType : uint8
 {
 	EAT_9mm UMETA(DisplayName = "9mm"),
 	EAT_AR UMETA(DisplayName = "Assault Rifle"),
+	EAT_Shells UMETA(DisplayName = "Shotgun Shells"),
 
 	EAT_MAX UMETA(DisplayName = "DefaultMAX")
 };
\ No newline at end of file
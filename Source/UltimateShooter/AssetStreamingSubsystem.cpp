@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AssetStreamingSubsystem.h"
+#include "UltimateShooter.h"
+#include "Item.h"
+#include "ItemDefinition.h"
+#include "ItemGridSubsystem.h"
+#include "Algo/Count.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarAssetStreamingAsync(
+	TEXT("Shooter.AssetStreaming.Async"),
+	true,
+	TEXT("Stream requested assets in asynchronously.\n")
+	TEXT("False loads them synchronously on the game thread when requested, for comparison."));
+
+static TAutoConsoleVariable<float> CVarAssetStreamingPrefetchDistance(
+	TEXT("Shooter.AssetStreaming.PrefetchDistance"),
+	2000.f,
+	TEXT("Distance from a character at which an item's assets start streaming in, on top of the item's pickup radius."));
+
+static FAutoConsoleCommandWithWorld AssetStreamingStatsCommand(
+	TEXT("Shooter.AssetStreaming.Stats"),
+	TEXT("Log asset streaming requests, load times and the memory taken by streamed assets for the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UAssetStreamingSubsystem* AssetStreaming = World ? World->GetSubsystem<UAssetStreamingSubsystem>() : nullptr)
+		{
+			AssetStreaming->DumpStats();
+		}
+	}));
+
+DECLARE_CYCLE_STAT(TEXT("Asset Streaming Sync Load"), STAT_AssetStreamingSyncLoad, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asset Streaming Requests"), STAT_AssetStreamingRequests, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asset Streaming Pending"), STAT_AssetStreamingPending, STATGROUP_UltimateShooter);
+
+UAssetStreamingSubsystem::UAssetStreamingSubsystem() :
+	NumPendingRequests(0)
+{
+}
+
+bool UAssetStreamingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAssetStreamingSubsystem::Deinitialize()
+{
+	for (auto& DefinitionHandle : DefinitionHandles)
+	{
+		if (DefinitionHandle.Value.IsValid())
+		{
+			DefinitionHandle.Value->ReleaseHandle();
+		}
+	}
+	DefinitionHandles.Empty();
+
+	DEC_DWORD_STAT_BY(STAT_AssetStreamingRequests, Requests.Num());
+	DEC_DWORD_STAT_BY(STAT_AssetStreamingPending, NumPendingRequests);
+	Requests.Empty();
+	NumPendingRequests = 0;
+
+	Super::Deinitialize();
+}
+
+TSharedPtr<FStreamableHandle> UAssetStreamingSubsystem::RequestAssets(TArray<FSoftObjectPath> Assets, FStreamableDelegate OnLoaded, const FString& DebugName)
+{
+	Assets.RemoveAll([](const FSoftObjectPath& Asset) { return Asset.IsNull(); });
+	if (Assets.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return nullptr;
+	}
+
+	const int32 RequestIndex = Requests.Num();
+	FAssetStreamingRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.DebugName = DebugName;
+	Request.Assets = Assets;
+	Request.NumResidentAtRequest = Algo::CountIf(Assets, [](const FSoftObjectPath& Asset) { return Asset.ResolveObject() != nullptr; });
+	Request.RequestTime = FPlatformTime::Seconds();
+	Request.LoadTime = -1.0;
+	++NumPendingRequests;
+	INC_DWORD_STAT(STAT_AssetStreamingRequests);
+	INC_DWORD_STAT(STAT_AssetStreamingPending);
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	if (CVarAssetStreamingAsync.GetValueOnGameThread())
+	{
+		return StreamableManager.RequestAsyncLoad(
+			MoveTemp(Assets),
+			FStreamableDelegate::CreateWeakLambda(this, [this, RequestIndex, OnLoaded]()
+			{
+				OnRequestLoaded(RequestIndex);
+				OnLoaded.ExecuteIfBound();
+			}),
+			FStreamableManager::DefaultAsyncLoadPriority,
+			false,
+			false,
+			DebugName
+		);
+	}
+
+	TSharedPtr<FStreamableHandle> Handle;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AssetStreamingSyncLoad);
+		Handle = StreamableManager.RequestSyncLoad(MoveTemp(Assets), false, DebugName);
+	}
+	OnRequestLoaded(RequestIndex);
+	OnLoaded.ExecuteIfBound();
+	return Handle;
+}
+
+void UAssetStreamingSubsystem::RequestDefinitionAssets(const UItemDefinition* Definition)
+{
+	if (Definition == nullptr || DefinitionHandles.Contains(Definition)) return;
+
+	TArray<FSoftObjectPath> Assets;
+	Definition->GetStreamedAssets(Assets);
+	DefinitionHandles.Add(Definition, RequestAssets(MoveTemp(Assets), FStreamableDelegate(), Definition->GetName()));
+}
+
+void UAssetStreamingSubsystem::PrefetchItemsNear(const FVector& Location)
+{
+	const UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>();
+	if (ItemGrid == nullptr) return;
+
+	TArray<AItem*> NearbyItems;
+	ItemGrid->GetItemsInRange(Location, CVarAssetStreamingPrefetchDistance.GetValueOnGameThread(), NearbyItems);
+	for (const AItem* Item : NearbyItems)
+	{
+		RequestDefinitionAssets(Item->GetDefinition());
+	}
+}
+
+void UAssetStreamingSubsystem::OnRequestLoaded(int32 RequestIndex)
+{
+	if (!Requests.IsValidIndex(RequestIndex)) return;
+
+	FAssetStreamingRequest& Request = Requests[RequestIndex];
+	if (Request.LoadTime >= 0.0) return;
+
+	Request.LoadTime = FPlatformTime::Seconds() - Request.RequestTime;
+	--NumPendingRequests;
+	DEC_DWORD_STAT(STAT_AssetStreamingPending);
+}
+
+void UAssetStreamingSubsystem::DumpStats() const
+{
+	int32 NumAssets = 0;
+	int32 NumResidentAtRequest = 0;
+	double TotalLoadTime = 0.0;
+	double MaxLoadTime = 0.0;
+	TSet<FSoftObjectPath> UniqueAssets;
+	for (const FAssetStreamingRequest& Request : Requests)
+	{
+		NumAssets += Request.Assets.Num();
+		NumResidentAtRequest += Request.NumResidentAtRequest;
+		UniqueAssets.Append(Request.Assets);
+		if (Request.LoadTime >= 0.0)
+		{
+			TotalLoadTime += Request.LoadTime;
+			MaxLoadTime = FMath::Max(MaxLoadTime, Request.LoadTime);
+		}
+	}
+
+	// What the streamed assets cost now, these used to be resident from map load on
+	int32 NumResident = 0;
+	SIZE_T ResidentBytes = 0;
+	for (const FSoftObjectPath& Asset : UniqueAssets)
+	{
+		if (UObject* Object = Asset.ResolveObject())
+		{
+			++NumResident;
+			ResidentBytes += Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+
+	const int32 NumLoaded = Requests.Num() - NumPendingRequests;
+	UE_LOG(LogUltimateShooter, Log, TEXT("Asset streaming (%s): %d requests (%d pending), %d assets, %d already resident when requested"),
+		CVarAssetStreamingAsync.GetValueOnGameThread() ? TEXT("async") : TEXT("sync"),
+		Requests.Num(),
+		NumPendingRequests,
+		NumAssets,
+		NumResidentAtRequest);
+	UE_LOG(LogUltimateShooter, Log, TEXT("    load time %.2f ms average, %.2f ms max"),
+		NumLoaded > 0 ? TotalLoadTime * 1000.0 / NumLoaded : 0.0,
+		MaxLoadTime * 1000.0);
+	UE_LOG(LogUltimateShooter, Log, TEXT("    %d of %d streamed assets resident, %.1f KB"),
+		NumResident,
+		UniqueAssets.Num(),
+		ResidentBytes / 1024.0);
+
+	for (const FAssetStreamingRequest& Request : Requests)
+	{
+		if (Request.LoadTime >= 0.0)
+		{
+			UE_LOG(LogUltimateShooter, Log, TEXT("    %s: %d assets, %.2f ms"), *Request.DebugName, Request.Assets.Num(), Request.LoadTime * 1000.0);
+		}
+		else
+		{
+			UE_LOG(LogUltimateShooter, Log, TEXT("    %s: %d assets, loading"), *Request.DebugName, Request.Assets.Num());
+		}
+	}
+}
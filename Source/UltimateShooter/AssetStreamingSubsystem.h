@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "UObject/ObjectKey.h"
+#include "AssetStreamingSubsystem.generated.h"
+
+class UItemDefinition;
+
+/* One batch of assets streamed in, kept for the stats */
+struct FAssetStreamingRequest
+{
+	FString DebugName;
+
+	TArray<FSoftObjectPath> Assets;
+
+	/* Assets that were already in memory when requested, loaded with the map or by an earlier request */
+	int32 NumResidentAtRequest;
+
+	double RequestTime;
+
+	/* Seconds from request to all assets resident, negative while still loading */
+	double LoadTime;
+};
+
+/**
+ * Streams cosmetics (sounds, particles, montages, curves) in when they are first needed instead of
+ * loading them with the map. Item definitions are requested when an item of their kind comes near
+ * a character and stay resident for the rest of the world's lifetime. Everything that uses the
+ * assets has to cope with them not being loaded yet
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UAssetStreamingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UAssetStreamingSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/**
+	* Stream Assets in, null paths are skipped
+	* @param OnLoaded  Called once every asset is resident
+	* @return Handle keeping the assets loaded until it is released, null if there was nothing to load
+	*/
+	TSharedPtr<FStreamableHandle> RequestAssets(TArray<FSoftObjectPath> Assets, FStreamableDelegate OnLoaded, const FString& DebugName);
+
+	/* Stream Definition's assets in, does nothing if they were requested before */
+	void RequestDefinitionAssets(const UItemDefinition* Definition);
+
+	/* Request the definitions of every item within prefetch distance of Location */
+	void PrefetchItemsNear(const FVector& Location);
+
+	/* Log request counters, load times and the memory taken by streamed assets */
+	void DumpStats() const;
+
+private:
+	/* Record the load time of Requests[RequestIndex] */
+	void OnRequestLoaded(int32 RequestIndex);
+
+	/* Every request made in this world */
+	TArray<FAssetStreamingRequest> Requests;
+
+	/* Handles keeping the assets of requested item definitions loaded */
+	TMap<FObjectKey, TSharedPtr<FStreamableHandle>> DefinitionHandles;
+
+	int32 NumPendingRequests;
+};
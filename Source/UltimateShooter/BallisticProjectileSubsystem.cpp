@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BallisticProjectileSubsystem.h"
+#include "UltimateShooter.h"
+#include "EffectPoolSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+
+static TAutoConsoleVariable<int32> CVarProjectileMaxSweepsPerFrame(
+	TEXT("Shooter.Projectiles.MaxSweepsPerFrame"),
+	2048,
+	TEXT("Most collision traces the projectile manager issues per frame.\n")
+	TEXT("Projectiles that miss a frame trace a longer segment next time."));
+
+static TAutoConsoleVariable<int32> CVarProjectileMaxProjectiles(
+	TEXT("Shooter.Projectiles.MaxProjectiles"),
+	65536,
+	TEXT("Most projectiles in flight per world. Projectiles fired past the limit are dropped."));
+
+static TAutoConsoleVariable<float> CVarProjectileLifetime(
+	TEXT("Shooter.Projectiles.Lifetime"),
+	4.f,
+	TEXT("Seconds a projectile flies before it is removed without hitting anything."));
+
+DECLARE_CYCLE_STAT(TEXT("Projectiles Integrate"), STAT_ProjectilesIntegrate, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Resolve Sweeps"), STAT_ProjectilesResolveSweeps, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Issue Sweeps"), STAT_ProjectilesIssueSweeps, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Projectiles"), STAT_LiveProjectiles, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Sweeps"), STAT_ProjectileSweeps, STATGROUP_UltimateShooter);
+
+UBallisticProjectileSubsystem::UBallisticProjectileSubsystem() :
+	SweepCursor(0)
+{
+}
+
+bool UBallisticProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallisticProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetNumProjectiles() == 0) return;
+
+	ResolveSweeps();
+	Integrate(DeltaTime);
+	IssueSweeps();
+	RemoveDeadProjectiles();
+
+	INC_DWORD_STAT_BY(STAT_LiveProjectiles, GetNumProjectiles());
+}
+
+TStatId UBallisticProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBallisticProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void UBallisticProjectileSubsystem::FireProjectile(const FVector& Location, const FVector& Velocity, float DragCoefficient, float InDamage, AActor* Instigator, UParticleSystem* ImpactEffect)
+{
+	if (GetNumProjectiles() >= CVarProjectileMaxProjectiles.GetValueOnGameThread()) return;
+
+	PositionX.Add(Location.X);
+	PositionY.Add(Location.Y);
+	PositionZ.Add(Location.Z);
+	VelocityX.Add(Velocity.X);
+	VelocityY.Add(Velocity.Y);
+	VelocityZ.Add(Velocity.Z);
+	Drag.Add(DragCoefficient);
+	Age.Add(0.f);
+
+	SweepStart.Add(Location);
+	SweepHandles.AddDefaulted();
+	Damage.Add(InDamage);
+	Instigators.Add(Instigator);
+	ImpactEffectIndices.Add(ImpactEffect ? ImpactEffects.AddUnique(ImpactEffect) : INDEX_NONE);
+}
+
+void UBallisticProjectileSubsystem::Integrate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesIntegrate);
+
+	const int32 NumProjectiles = GetNumProjectiles();
+	const float GravityDelta = GetWorld()->GetGravityZ() * DeltaTime;
+
+	float* RESTRICT PosX = PositionX.GetData();
+	float* RESTRICT PosY = PositionY.GetData();
+	float* RESTRICT PosZ = PositionZ.GetData();
+	float* RESTRICT VelX = VelocityX.GetData();
+	float* RESTRICT VelY = VelocityY.GetData();
+	float* RESTRICT VelZ = VelocityZ.GetData();
+	const float* RESTRICT DragData = Drag.GetData();
+	float* RESTRICT AgeData = Age.GetData();
+
+	const VectorRegister4Float VecDeltaTime = VectorSetFloat1(DeltaTime);
+	const VectorRegister4Float VecGravityDelta = VectorSetFloat1(GravityDelta);
+
+	// Four projectiles at a time
+	int32 Index = 0;
+	for (; Index + 4 <= NumProjectiles; Index += 4)
+	{
+		VectorRegister4Float VX = VectorLoad(VelX + Index);
+		VectorRegister4Float VY = VectorLoad(VelY + Index);
+		VectorRegister4Float VZ = VectorLoad(VelZ + Index);
+
+		// Quadratic drag, v *= 1 - Drag * |v| * dt
+		const VectorRegister4Float SpeedSquared = VectorMultiplyAdd(VX, VX, VectorMultiplyAdd(VY, VY, VectorMultiply(VZ, VZ)));
+		const VectorRegister4Float DragLoss = VectorMultiply(VectorMultiply(VectorLoad(DragData + Index), VectorSqrt(SpeedSquared)), VecDeltaTime);
+		const VectorRegister4Float DragScale = VectorMax(VectorSubtract(GlobalVectorConstants::FloatOne, DragLoss), GlobalVectorConstants::FloatZero);
+
+		VX = VectorMultiply(VX, DragScale);
+		VY = VectorMultiply(VY, DragScale);
+		VZ = VectorMultiplyAdd(VZ, DragScale, VecGravityDelta);
+
+		VectorStore(VX, VelX + Index);
+		VectorStore(VY, VelY + Index);
+		VectorStore(VZ, VelZ + Index);
+		VectorStore(VectorMultiplyAdd(VX, VecDeltaTime, VectorLoad(PosX + Index)), PosX + Index);
+		VectorStore(VectorMultiplyAdd(VY, VecDeltaTime, VectorLoad(PosY + Index)), PosY + Index);
+		VectorStore(VectorMultiplyAdd(VZ, VecDeltaTime, VectorLoad(PosZ + Index)), PosZ + Index);
+		VectorStore(VectorAdd(VectorLoad(AgeData + Index), VecDeltaTime), AgeData + Index);
+	}
+
+	// Whatever doesn't fill a full vector
+	for (; Index < NumProjectiles; ++Index)
+	{
+		const float Speed = FMath::Sqrt(VelX[Index] * VelX[Index] + VelY[Index] * VelY[Index] + VelZ[Index] * VelZ[Index]);
+		const float DragScale = FMath::Max(1.f - DragData[Index] * Speed * DeltaTime, 0.f);
+
+		VelX[Index] *= DragScale;
+		VelY[Index] *= DragScale;
+		VelZ[Index] = VelZ[Index] * DragScale + GravityDelta;
+
+		PosX[Index] += VelX[Index] * DeltaTime;
+		PosY[Index] += VelY[Index] * DeltaTime;
+		PosZ[Index] += VelZ[Index] * DeltaTime;
+		AgeData[Index] += DeltaTime;
+	}
+
+	const float Lifetime = CVarProjectileLifetime.GetValueOnGameThread();
+	for (Index = 0; Index < NumProjectiles; ++Index)
+	{
+		if (AgeData[Index] > Lifetime)
+		{
+			DeadProjectiles.Add(Index);
+		}
+	}
+}
+
+void UBallisticProjectileSubsystem::ResolveSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesResolveSweeps);
+
+	UWorld* World = GetWorld();
+	for (int32 Index = 0; Index < GetNumProjectiles(); ++Index)
+	{
+		FTraceHandle& SweepHandle = SweepHandles[Index];
+		if (!SweepHandle.IsValid()) continue;
+
+		FTraceDatum SweepDatum;
+		if (World->QueryTraceData(SweepHandle, SweepDatum))
+		{
+			SweepHandle = FTraceHandle();
+			if (SweepDatum.OutHits.Num() > 0 && SweepDatum.OutHits[0].bBlockingHit)
+			{
+				const FHitResult& Hit = SweepDatum.OutHits[0];
+				if (ImpactEffectIndices[Index] != INDEX_NONE)
+				{
+					UEffectPoolSubsystem::SpawnEffect(this, ImpactEffects[ImpactEffectIndices[Index]], FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint));
+				}
+				ApplyHitDamage(Index, Hit);
+				DeadProjectiles.Add(Index);
+			}
+		}
+		else if (!World->IsTraceHandleValid(SweepHandle, false))
+		{
+			// Missed the frame the results were valid for, carry on from where that segment ended
+			SweepHandle = FTraceHandle();
+		}
+	}
+}
+
+void UBallisticProjectileSubsystem::ApplyHitDamage(int32 Index, const FHitResult& Hit)
+{
+	// Same rule as hitscan shots, only the server deals damage
+	AActor* HitActor = Hit.GetActor();
+	if (HitActor == nullptr || Damage[Index] <= 0.f || GetWorld()->GetNetMode() == NM_Client) return;
+
+	AActor* Instigator = Instigators[Index].Get();
+	const APawn* InstigatorPawn = Cast<APawn>(Instigator);
+	UGameplayStatics::ApplyPointDamage(
+		HitActor,
+		Damage[Index],
+		(Hit.TraceEnd - Hit.TraceStart).GetSafeNormal(),
+		Hit,
+		InstigatorPawn ? InstigatorPawn->GetController() : nullptr,
+		Instigator,
+		UDamageType::StaticClass()
+	);
+}
+
+void UBallisticProjectileSubsystem::IssueSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesIssueSweeps);
+
+	UWorld* World = GetWorld();
+	const int32 NumProjectiles = GetNumProjectiles();
+	const int32 MaxSweeps = FMath::Min(CVarProjectileMaxSweepsPerFrame.GetValueOnGameThread(), NumProjectiles);
+
+	// Round robin from where the last frame stopped so every projectile gets its turn
+	int32 NumSweeps = 0;
+	int32 Visited = 0;
+	for (; Visited < NumProjectiles && NumSweeps < MaxSweeps; ++Visited)
+	{
+		const int32 Index = (SweepCursor + Visited) % NumProjectiles;
+		if (SweepHandles[Index].IsValid()) continue;
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false, Instigators[Index].Get());
+		const FVector SweepEnd{ PositionX[Index], PositionY[Index], PositionZ[Index] };
+		SweepHandles[Index] = World->AsyncLineTraceByChannel(
+			EAsyncTraceType::Single,
+			SweepStart[Index],
+			SweepEnd,
+			ECollisionChannel::ECC_Visibility,
+			QueryParams
+		);
+		SweepStart[Index] = SweepEnd;
+		++NumSweeps;
+	}
+	SweepCursor = NumProjectiles > 0 ? (SweepCursor + Visited) % NumProjectiles : 0;
+
+	INC_DWORD_STAT_BY(STAT_ProjectileSweeps, NumSweeps);
+}
+
+void UBallisticProjectileSubsystem::RemoveDeadProjectiles()
+{
+	if (DeadProjectiles.Num() == 0) return;
+
+	// Back to front, so swapping in the last projectile never moves one that still has to go
+	DeadProjectiles.Sort(TGreater<int32>());
+	int32 LastRemoved = INDEX_NONE;
+	for (const int32 Index : DeadProjectiles)
+	{
+		if (Index == LastRemoved) continue;
+		LastRemoved = Index;
+
+		PositionX.RemoveAtSwap(Index, 1, false);
+		PositionY.RemoveAtSwap(Index, 1, false);
+		PositionZ.RemoveAtSwap(Index, 1, false);
+		VelocityX.RemoveAtSwap(Index, 1, false);
+		VelocityY.RemoveAtSwap(Index, 1, false);
+		VelocityZ.RemoveAtSwap(Index, 1, false);
+		Drag.RemoveAtSwap(Index, 1, false);
+		Age.RemoveAtSwap(Index, 1, false);
+		SweepStart.RemoveAtSwap(Index, 1, false);
+		SweepHandles.RemoveAtSwap(Index, 1, false);
+		Damage.RemoveAtSwap(Index, 1, false);
+		Instigators.RemoveAtSwap(Index, 1, false);
+		ImpactEffectIndices.RemoveAtSwap(Index, 1, false);
+	}
+	DeadProjectiles.Reset();
+
+	if (GetNumProjectiles() == 0)
+	{
+		ImpactEffects.Reset();
+		SweepCursor = 0;
+	}
+}
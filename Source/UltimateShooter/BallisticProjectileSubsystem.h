@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "BallisticProjectileSubsystem.generated.h"
+
+class UParticleSystem;
+
+/**
+ * Simulates every in-flight bullet of the world without an actor per bullet.
+ * Projectiles live in structure of arrays buffers, gravity and drag are integrated four at a time,
+ * and collisions are found with async segment traces issued in batches under a per frame budget.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UBallisticProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UBallisticProjectileSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	* Launch a projectile
+	* @param DragCoefficient  Quadratic drag, deceleration is DragCoefficient * Speed^2
+	* @param Damage  Point damage dealt to the actor the projectile hits, on the server
+	* @param Instigator  Ignored by the projectile's traces, causes the damage
+	* @param ImpactEffect  Spawned where the projectile hits, may be null
+	*/
+	void FireProjectile(const FVector& Location, const FVector& Velocity, float DragCoefficient, float Damage, AActor* Instigator, UParticleSystem* ImpactEffect);
+
+	FORCEINLINE int32 GetNumProjectiles() const { return PositionX.Num(); }
+
+private:
+	/* Apply gravity and drag and move every projectile */
+	void Integrate(float DeltaTime);
+
+	/* Handle the traces issued last frame, collects projectiles that hit something */
+	void ResolveSweeps();
+
+	/* Deal projectile Index's damage to the actor it hit */
+	void ApplyHitDamage(int32 Index, const FHitResult& Hit);
+
+	/* Trace the distance projectiles moved since their last trace, up to the frame budget */
+	void IssueSweeps();
+
+	/* Remove the projectiles in DeadProjectiles */
+	void RemoveDeadProjectiles();
+
+	/* Hot data, touched by Integrate every tick */
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> Drag;
+	TArray<float> Age;
+
+	/* Cold data, touched when sweeping */
+	TArray<FVector> SweepStart;
+	TArray<FTraceHandle> SweepHandles;
+	TArray<float> Damage;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+
+	/* Index into ImpactEffects, INDEX_NONE for projectiles without one */
+	TArray<int32> ImpactEffectIndices;
+
+	/* Impact effects used by live projectiles, indexed by ImpactEffectIndices */
+	UPROPERTY()
+	TArray<UParticleSystem*> ImpactEffects;
+
+	/* Projectiles to remove at the end of the tick */
+	TArray<int32> DeadProjectiles;
+
+	/* Where IssueSweeps continues next frame when it ran out of budget */
+	int32 SweepCursor;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CachedSocket.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+
+FCachedSocket::FCachedSocket(FName InName) :
+	Name(InName)
+{
+}
+
+bool FCachedSocket::Resolve(const USkeletalMeshComponent* Component)
+{
+	Socket = nullptr;
+	BoneIndex = INDEX_NONE;
+	LocalTransform = FTransform::Identity;
+
+	const USkeletalMesh* Mesh = Component ? Component->GetSkeletalMeshAsset() : nullptr;
+	ResolvedMesh = Mesh;
+	if (Mesh == nullptr || Name.IsNone()) return false;
+
+	if (const USkeletalMeshSocket* MeshSocket = Mesh->FindSocket(Name))
+	{
+		Socket = MeshSocket;
+		BoneIndex = Component->GetBoneIndex(MeshSocket->BoneName);
+		LocalTransform = MeshSocket->GetSocketLocalTransform();
+	}
+	else
+	{
+		// Not a socket, bones can be read the same way with no offset
+		BoneIndex = Component->GetBoneIndex(Name);
+	}
+	return IsValid();
+}
+
+bool FCachedSocket::Validate(const USkeletalMeshComponent* Component)
+{
+	if (Component == nullptr) return false;
+
+	if (Component->GetSkeletalMeshAsset() != ResolvedMesh.Get())
+	{
+		return Resolve(Component);
+	}
+	return IsValid();
+}
+
+bool FCachedSocket::GetWorldTransform(const USkeletalMeshComponent* Component, FTransform& OutTransform)
+{
+	if (!Validate(Component)) return false;
+
+	// Same as USkeletalMeshSocket::GetSocketTransform, minus the search by name
+	OutTransform = LocalTransform * Component->GetBoneTransform(BoneIndex);
+	return true;
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkeletalMesh;
+class USkeletalMeshComponent;
+class USkeletalMeshSocket;
+
+/**
+ * Socket or bone of a skeletal mesh resolved once to a bone index and an offset from that bone,
+ * so reading its transform doesn't search the mesh by name. Resolves again by itself when the
+ * component's mesh asset changes.
+ */
+struct ULTIMATESHOOTER_API FCachedSocket
+{
+	explicit FCachedSocket(FName InName = NAME_None);
+
+	/* Look up Name on Component's current mesh, as a socket first and as a bone otherwise */
+	bool Resolve(const USkeletalMeshComponent* Component);
+
+	/* Resolve again if Component's mesh asset isn't the one the cache was resolved against */
+	bool Validate(const USkeletalMeshComponent* Component);
+
+	/* World transform of the socket or bone, false if Component's mesh doesn't have it */
+	bool GetWorldTransform(const USkeletalMeshComponent* Component, FTransform& OutTransform);
+
+	FORCEINLINE FName GetName() const { return Name; }
+
+	/* Mesh socket Name resolved to, null when Name is a plain bone */
+	FORCEINLINE const USkeletalMeshSocket* GetSocket() const { return Socket; }
+
+	FORCEINLINE int32 GetBoneIndex() const { return BoneIndex; }
+	FORCEINLINE bool IsValid() const { return BoneIndex != INDEX_NONE; }
+
+private:
+	FName Name;
+
+	/* Mesh asset the cache was resolved against */
+	TWeakObjectPtr<const USkeletalMesh> ResolvedMesh;
+
+	const USkeletalMeshSocket* Socket = nullptr;
+
+	/* Bone the socket is attached to */
+	int32 BoneIndex = INDEX_NONE;
+
+	/* Socket offset from its bone, identity for bones */
+	FTransform LocalTransform;
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EffectPoolSubsystem.h"
+#include "UltimateShooter.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+
+static TAutoConsoleVariable<int32> CVarEffectPoolMaxComponents(
+	TEXT("Shooter.EffectPool.MaxComponents"),
+	128,
+	TEXT("Maximum number of particle system components the effect pool creates per world.\n")
+	TEXT("Once reached, the oldest playing effect is recycled."));
+
+static FAutoConsoleCommandWithWorld EffectPoolStatsCommand(
+	TEXT("Shooter.EffectPool.Stats"),
+	TEXT("Log effect pool occupancy and hit/miss counters for the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UEffectPoolSubsystem* EffectPool = World ? World->GetSubsystem<UEffectPoolSubsystem>() : nullptr)
+		{
+			EffectPool->DumpStats();
+		}
+	}));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Components"), STAT_EffectPoolComponents, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Active"), STAT_EffectPoolActive, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Hits"), STAT_EffectPoolHits, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Misses"), STAT_EffectPoolMisses, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Effect Pool Recycles"), STAT_EffectPoolRecycles, STATGROUP_UltimateShooter);
+
+UEffectPoolSubsystem::UEffectPoolSubsystem() :
+	NumComponents(0),
+	PoolHits(0),
+	PoolMisses(0),
+	PoolRecycles(0)
+{
+}
+
+bool UEffectPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEffectPoolSubsystem::Deinitialize()
+{
+	for (auto& Bucket : Buckets)
+	{
+		for (UParticleSystemComponent* Component : Bucket.Value.FreeComponents)
+		{
+			if (IsValid(Component))
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	for (UParticleSystemComponent* Component : ActiveComponents)
+	{
+		if (IsValid(Component))
+		{
+			Component->DestroyComponent();
+		}
+	}
+	Buckets.Empty();
+	ActiveComponents.Empty();
+
+	DEC_DWORD_STAT_BY(STAT_EffectPoolComponents, NumComponents);
+	NumComponents = 0;
+
+	Super::Deinitialize();
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::SpawnEffect(const UObject* WorldContextObject, UParticleSystem* Template, const FTransform& Transform)
+{
+	if (Template == nullptr || WorldContextObject == nullptr) return nullptr;
+
+	UWorld* World = WorldContextObject->GetWorld();
+	if (UEffectPoolSubsystem* EffectPool = World ? World->GetSubsystem<UEffectPoolSubsystem>() : nullptr)
+	{
+		return EffectPool->AcquireEffect(Template, Transform);
+	}
+	return UGameplayStatics::SpawnEmitterAtLocation(World, Template, Transform);
+}
+
+void UEffectPoolSubsystem::Prewarm(UParticleSystem* Template, int32 Count)
+{
+	if (Template == nullptr) return;
+
+	FEffectPoolBucket& Bucket = Buckets.FindOrAdd(Template);
+	const int32 MaxComponents = CVarEffectPoolMaxComponents.GetValueOnGameThread();
+	while (Bucket.FreeComponents.Num() < Count && NumComponents < MaxComponents)
+	{
+		Bucket.FreeComponents.Add(CreateComponent(Template));
+	}
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::AcquireEffect(UParticleSystem* Template, const FTransform& Transform)
+{
+	if (Template == nullptr) return nullptr;
+
+	UParticleSystemComponent* Component = nullptr;
+
+	FEffectPoolBucket* Bucket = Buckets.Find(Template);
+	if (Bucket && Bucket->FreeComponents.Num() > 0)
+	{
+		Component = Bucket->FreeComponents.Pop(false);
+		++PoolHits;
+		INC_DWORD_STAT(STAT_EffectPoolHits);
+	}
+	else if (NumComponents < CVarEffectPoolMaxComponents.GetValueOnGameThread())
+	{
+		Component = CreateComponent(Template);
+		++PoolMisses;
+		INC_DWORD_STAT(STAT_EffectPoolMisses);
+	}
+	else
+	{
+		Component = RecycleComponent(Template);
+		++PoolRecycles;
+		INC_DWORD_STAT(STAT_EffectPoolRecycles);
+	}
+
+	if (Component == nullptr) return nullptr;
+
+	Component->SetWorldTransform(Transform);
+	Component->Activate(true);
+	ActiveComponents.Add(Component);
+	INC_DWORD_STAT(STAT_EffectPoolActive);
+
+	return Component;
+}
+
+void UEffectPoolSubsystem::DumpStats() const
+{
+	UE_LOG(LogUltimateShooter, Log, TEXT("Effect pool: %d components (%d active, max %d), %d hits, %d misses, %d recycles"),
+		NumComponents,
+		ActiveComponents.Num(),
+		CVarEffectPoolMaxComponents.GetValueOnGameThread(),
+		PoolHits,
+		PoolMisses,
+		PoolRecycles);
+
+	for (const auto& Bucket : Buckets)
+	{
+		UE_LOG(LogUltimateShooter, Log, TEXT("    %s: %d free"), *GetNameSafe(Bucket.Key), Bucket.Value.FreeComponents.Num());
+	}
+}
+
+void UEffectPoolSubsystem::OnEffectFinished(UParticleSystemComponent* Component)
+{
+	// Components taken over by RecycleComponent are no longer active and are ignored here
+	if (Component == nullptr || ActiveComponents.RemoveSingle(Component) == 0) return;
+	DEC_DWORD_STAT(STAT_EffectPoolActive);
+
+	// Parameters like the beam Target belong to the effect that just finished
+	Component->InstanceParameters.Reset();
+	Buckets.FindOrAdd(Component->Template).FreeComponents.Add(Component);
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::CreateComponent(UParticleSystem* Template)
+{
+	UWorld* World = GetWorld();
+
+	// Same outer UGameplayStatics uses for emitters that aren't attached to anything
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World->GetWorldSettings(), NAME_None, RF_Transient);
+	Component->bAutoDestroy = false;
+	Component->bAutoActivate = false;
+	Component->SetUsingAbsoluteLocation(true);
+	Component->SetUsingAbsoluteRotation(true);
+	Component->SetUsingAbsoluteScale(true);
+	Component->SetTemplate(Template);
+	Component->OnSystemFinished.AddDynamic(this, &UEffectPoolSubsystem::OnEffectFinished);
+	Component->RegisterComponentWithWorld(World);
+
+	++NumComponents;
+	INC_DWORD_STAT(STAT_EffectPoolComponents);
+
+	return Component;
+}
+
+UParticleSystemComponent* UEffectPoolSubsystem::RecycleComponent(UParticleSystem* Template)
+{
+	UParticleSystemComponent* Component = nullptr;
+
+	if (ActiveComponents.Num() > 0)
+	{
+		// Cut the oldest playing effect short
+		Component = ActiveComponents[0];
+		ActiveComponents.RemoveAt(0, 1, false);
+		DEC_DWORD_STAT(STAT_EffectPoolActive);
+		Component->DeactivateImmediate();
+	}
+	else
+	{
+		// Nothing is playing, borrow a free component prewarmed for another asset
+		for (auto& Bucket : Buckets)
+		{
+			if (Bucket.Value.FreeComponents.Num() > 0)
+			{
+				Component = Bucket.Value.FreeComponents.Pop(false);
+				break;
+			}
+		}
+	}
+
+	if (Component)
+	{
+		Component->InstanceParameters.Reset();
+		if (Component->Template != Template)
+		{
+			Component->SetTemplate(Template);
+		}
+	}
+	return Component;
+}
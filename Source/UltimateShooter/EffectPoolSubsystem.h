@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EffectPoolSubsystem.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+
+/* Inactive components ready to be handed out for one particle system asset */
+USTRUCT()
+struct FEffectPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> FreeComponents;
+};
+
+/**
+ * Pools the particle system components used for muzzle flashes, impacts and beams
+ * so firing does not allocate, register and garbage collect a component per effect
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UEffectPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UEffectPoolSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/* Spawn Template through the world's pool, or as a plain emitter if there is no pool */
+	static UParticleSystemComponent* SpawnEffect(const UObject* WorldContextObject, UParticleSystem* Template, const FTransform& Transform);
+
+	/* Create inactive components for Template until it has at least Count of them */
+	void Prewarm(UParticleSystem* Template, int32 Count);
+
+	/* Hand out a pooled component for Template and activate it at Transform */
+	UParticleSystemComponent* AcquireEffect(UParticleSystem* Template, const FTransform& Transform);
+
+	/* Log pool occupancy and hit/miss counters */
+	void DumpStats() const;
+
+protected:
+	/* Bound to OnSystemFinished of every pooled component */
+	UFUNCTION()
+	void OnEffectFinished(UParticleSystemComponent* Component);
+
+private:
+	/* Construct and register a new inactive component for Template */
+	UParticleSystemComponent* CreateComponent(UParticleSystem* Template);
+
+	/* Take a component for Template when the pool is full, oldest active effect first */
+	UParticleSystemComponent* RecycleComponent(UParticleSystem* Template);
+
+	/* Free components per particle system asset */
+	UPROPERTY()
+	TMap<UParticleSystem*, FEffectPoolBucket> Buckets;
+
+	/* Components currently playing, oldest first */
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> ActiveComponents;
+
+	/* Number of components created by the pool, active or free */
+	int32 NumComponents;
+
+	/* Effects served from a free component */
+	int32 PoolHits;
+
+	/* Effects that had to create a new component */
+	int32 PoolMisses;
+
+	/* Effects that took over a component because the pool was full */
+	int32 PoolRecycles;
+
+public:
+	FORCEINLINE int32 GetNumComponents() const { return NumComponents; }
+	FORCEINLINE int32 GetNumActiveComponents() const { return ActiveComponents.Num(); }
+	FORCEINLINE int32 GetPoolHits() const { return PoolHits; }
+	FORCEINLINE int32 GetPoolMisses() const { return PoolMisses; }
+	FORCEINLINE int32 GetPoolRecycles() const { return PoolRecycles; }
+};
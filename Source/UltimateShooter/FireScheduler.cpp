@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireScheduler.h"
+#include "UltimateShooter.h"
+
+void FFireScheduler::ShotFired(float FireInterval)
+{
+	TimeUntilNextShot = FireInterval;
+	bCoolingDown = true;
+}
+
+int32 FFireScheduler::Advance(float DeltaTime, float FireInterval, bool bTriggerHeld, FShotAlphas& OutShotAlphas)
+{
+	OutShotAlphas.Reset();
+	if (!bCoolingDown) return 0;
+
+	TimeUntilNextShot -= DeltaTime;
+	while (TimeUntilNextShot <= 0.f)
+	{
+		if (!bTriggerHeld)
+		{
+			// Interval is over and nobody wants another shot
+			Reset();
+			break;
+		}
+		if (OutShotAlphas.Num() == MaxShotsPerTick)
+		{
+			// Drop whatever is still overdue rather than firing it next tick
+			TimeUntilNextShot = FMath::Max(TimeUntilNextShot, 0.f);
+			break;
+		}
+
+		// The shot was due DeltaTime + TimeUntilNextShot seconds into this tick
+		const float Alpha = DeltaTime > 0.f ? (DeltaTime + TimeUntilNextShot) / DeltaTime : 1.f;
+		OutShotAlphas.Add(FMath::Clamp(Alpha, 0.f, 1.f));
+
+		TimeUntilNextShot += FMath::Max(FireInterval, KINDA_SMALL_NUMBER);
+	}
+
+	return OutShotAlphas.Num();
+}
+
+void FFireScheduler::Reset()
+{
+	TimeUntilNextShot = 0.f;
+	bCoolingDown = false;
+}
+
+bool FFireScheduler::AcceptRemoteShot(double ShotTime, float FireInterval, float Tolerance)
+{
+	if (ShotTime < NextRemoteShotTime - Tolerance) return false;
+
+	// Counting from the previous allowed time rather than ShotTime keeps early shots from adding up
+	NextRemoteShotTime = FMath::Max(NextRemoteShotTime, ShotTime) + FMath::Max(FireInterval, KINDA_SMALL_NUMBER);
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/* Shots a timer that is re-armed on every shot fires in Duration seconds, the old AutoFireTimer behaviour */
+static int32 SimulateTimerRearmShots(float Duration, float FireInterval, float FrameTime)
+{
+	int32 Shots = 1;
+	float Time = 0.f;
+	float NextShotTime = FireInterval;
+	while (Time + FrameTime <= Duration)
+	{
+		Time += FrameTime;
+		if (Time >= NextShotTime)
+		{
+			// Timer fires on a frame boundary and the next one starts from there
+			++Shots;
+			NextShotTime = Time + FireInterval;
+		}
+	}
+	return Shots;
+}
+
+/* Shots FFireScheduler fires in Duration seconds */
+static int32 SimulateSchedulerShots(float Duration, float FireInterval, float FrameTime)
+{
+	FFireScheduler Scheduler;
+	FFireScheduler::FShotAlphas ShotAlphas;
+
+	int32 Shots = 1;
+	Scheduler.ShotFired(FireInterval);
+
+	float Time = 0.f;
+	while (Time + FrameTime <= Duration)
+	{
+		Time += FrameTime;
+		Shots += Scheduler.Advance(FrameTime, FireInterval, true, ShotAlphas);
+	}
+	return Shots;
+}
+
+static FAutoConsoleCommand FireRateBenchmarkCommand(
+	TEXT("Shooter.Bench.FireRate"),
+	TEXT("Compare rate of fire accuracy of FFireScheduler and a re-armed timer from 30 to 300 FPS.\n")
+	TEXT("Usage: Shooter.Bench.FireRate [FireInterval=0.1] [Duration=10]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const float FireInterval = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.1f;
+		const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.f;
+		if (FireInterval <= 0.f || Duration <= 0.f) return;
+
+		const int32 ExpectedShots = FMath::FloorToInt(Duration / FireInterval + KINDA_SMALL_NUMBER) + 1;
+		UE_LOG(LogUltimateShooter, Log, TEXT("Fire rate benchmark: %.3fs interval over %.1fs, %d shots expected"), FireInterval, Duration, ExpectedShots);
+
+		const int32 FrameRates[] = { 30, 45, 60, 75, 90, 120, 144, 165, 200, 240, 300 };
+		for (const int32 FrameRate : FrameRates)
+		{
+			const float FrameTime = 1.f / FrameRate;
+			const int32 TimerShots = SimulateTimerRearmShots(Duration, FireInterval, FrameTime);
+			const int32 SchedulerShots = SimulateSchedulerShots(Duration, FireInterval, FrameTime);
+
+			UE_LOG(LogUltimateShooter, Log, TEXT("    %3d FPS: timer %4d shots (%+6.2f%%), scheduler %4d shots (%+6.2f%%)"),
+				FrameRate,
+				TimerShots,
+				100.f * (TimerShots - ExpectedShots) / ExpectedShots,
+				SchedulerShots,
+				100.f * (SchedulerShots - ExpectedShots) / ExpectedShots);
+		}
+	}));
+
+#endif
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fire rate accumulator for automatic weapons. Tracks the time left until the next shot
+ * and works out how many shots became due during a tick, and where inside the tick each
+ * one was due, so the rate of fire does not depend on the frame rate.
+ */
+struct ULTIMATESHOOTER_API FFireScheduler
+{
+	/* Most shots a single tick can fire, stops a hitch from emptying the magazine at once */
+	static constexpr int32 MaxShotsPerTick = 8;
+
+	using FShotAlphas = TArray<float, TInlineAllocator<MaxShotsPerTick>>;
+
+	/* Start the cooldown for a shot that was fired right now */
+	void ShotFired(float FireInterval);
+
+	/**
+	* Advance the cooldown by DeltaTime
+	* @param FireInterval  Seconds between two shots
+	* @param bTriggerHeld  False ends the cooldown as soon as the next shot would be due
+	* @param OutShotAlphas  For every shot due this tick, how far into the tick it was due [0, 1]
+	* @return Number of shots due this tick
+	*/
+	int32 Advance(float DeltaTime, float FireInterval, bool bTriggerHeld, FShotAlphas& OutShotAlphas);
+
+	/* Stop cooling down without firing again */
+	void Reset();
+
+	FORCEINLINE bool IsCoolingDown() const { return bCoolingDown; }
+
+	/**
+	* Server side cadence check for a shot a remote client fired, spaced by the client's shot times so network jitter doesn't matter
+	* @param ShotTime  Server time the client fired at
+	* @param Tolerance  Seconds a shot may come early, covers corrections to the client's estimate of the server clock
+	* @return False if the shot came sooner after the previous accepted one than FireInterval allows
+	*/
+	bool AcceptRemoteShot(double ShotTime, float FireInterval, float Tolerance);
+
+private:
+	/* Seconds until the next shot is due, negative while a shot is overdue within a tick */
+	float TimeUntilNextShot = 0.f;
+
+	/* True from a shot until the trigger is released and the interval has passed */
+	bool bCoolingDown = false;
+
+	/* Earliest shot time the next remote shot is accepted at, see AcceptRemoteShot */
+	double NextRemoteShotTime = TNumericLimits<double>::Lowest();
+};
@@ -2,199 +2,263 @@
 
 
 #include "Item.h"
+#include "UltimateShooter.h"
 #include "ShooterCharacter.h"
+#include "ItemGridSubsystem.h"
+#include "PickupProxySubsystem.h"
+#include "ItemInterpSubsystem.h"
+#include "ShooterDiagnosticsSubsystem.h"
 #include "Components/BoxComponent.h"
-#include "Components/WidgetComponent.h"
 #include "Components/SphereComponent.h"
-#include "Camera/CameraComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Sound/SoundCue.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ticking Items"), STAT_TickingItems, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Item State Transitions"), STAT_ItemStateTransitions, STATGROUP_UltimateShooter);
+
+/* Collision profiles from DefaultEngine.ini */
+static const FName ItemNoCollisionProfile(TEXT("NoCollision"));
+static const FName ItemFallingProfile(TEXT("ItemFalling"));
+static const FName ItemTraceTargetProfile(TEXT("ItemTraceTarget"));
+
+/* How an item's components are set up in one EItemState */
+struct FItemStateDescriptor
+{
+	/* False leaves the components as the previous state set them up */
+	bool bApply;
+
+	FName MeshProfile;
+	FName CollisionBoxProfile;
+
+	/* Simulate physics and gravity on the mesh */
+	bool bSimulatePhysics;
+
+	/* Make the mesh visible */
+	bool bShowMesh;
+
+	/* Hide the whole actor, for items parked in the item pool */
+	bool bHideActor;
+};
+
+/* Indexed by EItemState */
+static const FItemStateDescriptor ItemStateDescriptors[] =
+{
+	/* EIS_Pickup */
+	{ true, ItemNoCollisionProfile, ItemTraceTargetProfile, false, true, false },
+	/* EIS_EquipInterping */
+	{ true, ItemNoCollisionProfile, ItemNoCollisionProfile, false, true, false },
+	/* EIS_PickedUp */
+	{ false },
+	/* EIS_Equiped */
+	{ true, ItemNoCollisionProfile, ItemNoCollisionProfile, false, true, false },
+	/* EIS_Falling */
+	{ true, ItemFallingProfile, ItemNoCollisionProfile, true, false, false },
+	/* EIS_Parked */
+	{ true, ItemNoCollisionProfile, ItemNoCollisionProfile, false, false, true },
+};
+static_assert(UE_ARRAY_COUNT(ItemStateDescriptors) == static_cast<SIZE_T>(EItemState::EIS_MAX), "One descriptor per EItemState");
+
+/* Switch profile only when it changes, every switch recreates the component's physics state */
+static void ApplyCollisionProfile(UPrimitiveComponent* Component, FName ProfileName)
+{
+	if (Component->GetCollisionProfileName() == ProfileName) return;
+	Component->SetCollisionProfileName(ProfileName);
+}
 
 // Sets default values
 AItem::AItem():
-	ItemName(FString("Default")),
+	Definition(nullptr),
 	ItemCount(0),
-	ItemRarity(EItemRarity::EIR_Common),
 	ItemState(EItemState::EIS_Pickup),
 	// Item interp variables
-	ItemInterpStartLocation(FVector(0.f)),
 	CameraTargetLocation(FVector(0.f)),
 	bInterping(false),
-	ZCurveTime(0.7),
 	ItemInterpX(0.f),
 	ItemInterpY(0.f),
-	InterpInitialYawOffset(0)
+	bUsingPickupProxy(false),
+	Significance(ESignificance::ES_High)
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	// Only ticks while there is something to animate, see UpdateTickEnabled
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ItemMesh"));
 	SetRootComponent(ItemMesh);
 
 	CollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionBox"));
 	CollisionBox->SetupAttachment(ItemMesh);
-	CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
-
-	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
-	PickupWidget->SetupAttachment(GetRootComponent());
-
-	AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
-	AreaSphere->SetupAttachment(GetRootComponent());
+	CollisionBox->SetCollisionProfileName(ItemTraceTargetProfile);
+
+#if WITH_EDITORONLY_DATA
+	// Defaults the properties had before they moved to UItemDefinition
+	ItemName_DEPRECATED = FString("Default");
+	ItemRarity_DEPRECATED = EItemRarity::EIR_Common;
+	ItemZCurve_DEPRECATED = nullptr;
+	ItemScaleCurve_DEPRECATED = nullptr;
+	ZCurveTime_DEPRECATED = 0.7f;
+	PickupSound_DEPRECATED = nullptr;
+	EquipSound_DEPRECATED = nullptr;
+
+	// Same subobject name as before so saved radii load into it. Stripped from cooked builds and never collides
+	AreaSphere_DEPRECATED = CreateEditorOnlyDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
+	if (AreaSphere_DEPRECATED)
+	{
+		AreaSphere_DEPRECATED->SetupAttachment(ItemMesh);
+		AreaSphere_DEPRECATED->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		AreaSphere_DEPRECATED->SetGenerateOverlapEvents(false);
+	}
+#endif
 }
 
-// Called when the game starts or when spawned
-void AItem::BeginPlay()
+#if WITH_EDITOR
+void AItem::PostLoad()
 {
-	Super::BeginPlay();
-	
-	// Hide pickup widget
-	if (PickupWidget) {
-		PickupWidget->SetVisibility(false);
+	Super::PostLoad();
+
+	AItem* Archetype = Cast<AItem>(GetArchetype());
+	if (Archetype == nullptr) return;
+
+	// The archetype may have built its own definition, which items that don't override anything share
+	Archetype->ConditionalPostLoad();
+	if (Definition == nullptr && Archetype->Definition && Archetype->Definition->GetOuter() == Archetype)
+	{
+		Definition = Archetype->Definition;
 	}
-	SetActiveStars();
 
-	// Setup overlap for AreaSphere
-	AreaSphere->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnSphereOverlap);
-	AreaSphere->OnComponentEndOverlap.AddDynamic(this, &AItem::OnSphereEndOverlap);
+	// Saved before definitions existed, the deprecated properties still hold the values set on this Blueprint or placed
+	// item. Until a definition asset is assigned they go into a definition kept with the item, which cooking saves with it
+	const UItemDefinition* Template = GetMigrationTemplate();
+	UItemDefinition* Migrated = NewObject<UItemDefinition>(GetTransientPackage(), Template->GetClass(), NAME_None, RF_NoFlags, const_cast<UItemDefinition*>(Template));
+	if (!MigrateDeprecatedProperties(*Archetype, *Migrated)) return;
 
-	// Set item properties based on ItemState
-	SetItemProperties(ItemState);
+	Migrated->Rename(TEXT("MigratedDefinition"), this, REN_DontCreateRedirectors | REN_NonTransactional);
+	Migrated->SetFlags(GetMaskedFlags(RF_PropagateToSubObjects));
+	Definition = Migrated;
+
+	UE_LOG(LogUltimateShooter, Log, TEXT("%s: built a definition from properties saved before item definitions, assign a definition asset"), *GetPathName());
 }
 
-void AItem::OnSphereOverlap(
-	UPrimitiveComponent* OverlappedComponent, 
-	AActor* OtherActor, 
-	UPrimitiveComponent* OtherCompo, 
-	int32 OtherBodyIndex, 
-	bool bFromSweep, 
-	const FHitResult& SweepResult)
+const UItemDefinition* AItem::GetMigrationTemplate() const
 {
-	if (OtherActor)
+	return GetDefinition();
+}
+
+bool AItem::MigrateDeprecatedProperties(const AItem& Archetype, UItemDefinition& Migrated) const
+{
+	bool bMigrated = false;
+	auto MigrateIfOverridden = [&bMigrated](const auto& Value, const auto& ArchetypeValue, auto& Target)
 	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
-		{
-			ShooterCharacter->IncrementOverlappedItemCount(1);
-		}
+		if (Value == ArchetypeValue) return;
+
+		Target = Value;
+		bMigrated = true;
+	};
+	MigrateIfOverridden(ItemName_DEPRECATED, Archetype.ItemName_DEPRECATED, Migrated.ItemName);
+	MigrateIfOverridden(ItemRarity_DEPRECATED, Archetype.ItemRarity_DEPRECATED, Migrated.ItemRarity);
+	MigrateIfOverridden(ItemZCurve_DEPRECATED, Archetype.ItemZCurve_DEPRECATED, Migrated.ItemZCurve);
+	MigrateIfOverridden(ItemScaleCurve_DEPRECATED, Archetype.ItemScaleCurve_DEPRECATED, Migrated.ItemScaleCurve);
+	MigrateIfOverridden(ZCurveTime_DEPRECATED, Archetype.ZCurveTime_DEPRECATED, Migrated.ZCurveTime);
+	MigrateIfOverridden(PickupSound_DEPRECATED, Archetype.PickupSound_DEPRECATED, Migrated.PickupSound);
+	MigrateIfOverridden(EquipSound_DEPRECATED, Archetype.EquipSound_DEPRECATED, Migrated.EquipSound);
+	if (AreaSphere_DEPRECATED && Archetype.AreaSphere_DEPRECATED)
+	{
+		MigrateIfOverridden(AreaSphere_DEPRECATED->GetUnscaledSphereRadius(), Archetype.AreaSphere_DEPRECATED->GetUnscaledSphereRadius(), Migrated.PickupRadius);
 	}
+	return bMigrated;
 }
+#endif
 
-void AItem::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+// Called when the game starts or when spawned
+void AItem::BeginPlay()
 {
-	if (OtherActor)
+	Super::BeginPlay();
+
+	// Set item properties based on ItemState
+	SetItemProperties(ItemState);
+	UpdateItemGrid();
+	UpdatePickupProxy();
+	OnItemStateChanged();
+
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
 	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
-		{
-			ShooterCharacter->IncrementOverlappedItemCount(-1);
-		}
+		SignificanceSubsystem->RegisterActor(this, FOnSignificanceChanged::CreateUObject(this, &AItem::SetSignificance));
 	}
 }
 
-void AItem::SetActiveStars()
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	for (int32 i = 0; i <= 5; i++)
+	if (UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>())
 	{
-		ActiveStars.Add(false);
+		ItemGrid->RemoveItem(this);
 	}
-
-	int32 ItemRarityStarsAmount;
-	switch (ItemRarity)
+	if (UPickupProxySubsystem* PickupProxies = GetWorld()->GetSubsystem<UPickupProxySubsystem>())
 	{
-	case EItemRarity::EIR_Damaged:
-		ItemRarityStarsAmount = 1;
-		break;
-	case EItemRarity::EIR_Common:
-		ItemRarityStarsAmount = 2;
-		break;
-	case EItemRarity::EIR_Uncommon:
-		ItemRarityStarsAmount = 3;
-		break;
-	case EItemRarity::EIR_Rare:
-		ItemRarityStarsAmount = 4;
-		break;
-	case EItemRarity::EIR_Legendary:
-		ItemRarityStarsAmount = 5;
-		break;
-	case EItemRarity::EIR_MAX:
-		ItemRarityStarsAmount = 5;
-		break;
-	default:
-		ItemRarityStarsAmount = 0;
-		break;
+		PickupProxies->RemoveItem(this);
 	}
-	for (int32 i = 1; i <= ItemRarityStarsAmount; i++) {
-		ActiveStars[i] = true;
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
+	{
+		SignificanceSubsystem->UnregisterActor(this);
 	}
+	if (UItemInterpSubsystem* ItemInterp = bInterping ? GetWorld()->GetSubsystem<UItemInterpSubsystem>() : nullptr)
+	{
+		ItemInterp->StopInterp(this);
+	}
+
+	if (IsActorTickEnabled())
+	{
+		DEC_DWORD_STAT(STAT_TickingItems);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AItem::SetItemProperties(EItemState State)
 {
-	switch (State)
+	SCOPE_CYCLE_COUNTER(STAT_ItemStateTransitions);
+
+	const uint8 StateIndex = static_cast<uint8>(State);
+	if (StateIndex >= UE_ARRAY_COUNT(ItemStateDescriptors)) return;
+
+	const FItemStateDescriptor& Descriptor = ItemStateDescriptors[StateIndex];
+	if (!Descriptor.bApply) return;
+
+	if (Descriptor.bShowMesh)
+	{
+		// Left hidden when a pickup proxy is about to stand in for it
+		const UPickupProxySubsystem* PickupProxies = GetWorld()->GetSubsystem<UPickupProxySubsystem>();
+		ItemMesh->SetVisibility(!(PickupProxies && PickupProxies->CanProxyItem(this, State)));
+	}
+	if (IsHidden() != Descriptor.bHideActor)
+	{
+		SetActorHiddenInGame(Descriptor.bHideActor);
+	}
+
+	auto SetMeshSimulatePhysics = [this](bool bSimulate)
+	{
+		if (ItemMesh->IsSimulatingPhysics() != bSimulate)
+		{
+			ItemMesh->SetSimulatePhysics(bSimulate);
+		}
+		if (ItemMesh->IsGravityEnabled() != bSimulate)
+		{
+			ItemMesh->SetEnableGravity(bSimulate);
+		}
+	};
+
+	// Stop simulating before the profile takes away the collision the body simulates with
+	if (!Descriptor.bSimulatePhysics)
+	{
+		SetMeshSimulatePhysics(false);
+	}
+
+	ApplyCollisionProfile(ItemMesh, Descriptor.MeshProfile);
+	ApplyCollisionProfile(CollisionBox, Descriptor.CollisionBoxProfile);
+
+	if (Descriptor.bSimulatePhysics)
 	{
-	case EItemState::EIS_Pickup:
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set AreaSphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-		// Set CollisionBox properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-
-		break;
-	case EItemState::EIS_Equiped:
-		PickupWidget->SetVisibility(false);
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set AreaSphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set CollisionBox properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		break;
-	case EItemState::EIS_Falling:
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(true);
-		ItemMesh->SetEnableGravity(true);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldStatic, ECollisionResponse::ECR_Block);
-		// Set AreaSphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set CollisionBox properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		break;
-
-	case EItemState::EIS_EquipInterping:
-		PickupWidget->SetVisibility(false);
-		// Set mesh properties
-		ItemMesh->SetSimulatePhysics(false);
-		ItemMesh->SetEnableGravity(false);
-		ItemMesh->SetVisibility(true);
-		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set AreaSphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set CollisionBox properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
-		break;
+		SetMeshSimulatePhysics(true);
 	}
 }
 
@@ -209,86 +273,212 @@ void AItem::FinishInterping()
 	SetActorScale3D(FVector(1.f));
 }
 
-void AItem::ItemInterp(float DeltaTime)
+bool AItem::NeedsTick() const
 {
-	if (!bInterping) return;
+	return false;
+}
+
+void AItem::UpdateTickEnabled()
+{
+	const bool bNeedsTick = NeedsTick();
+	if (bNeedsTick == IsActorTickEnabled()) return;
 
-	if (Character && ItemZCurve)
+	SetActorTickEnabled(bNeedsTick);
+	if (bNeedsTick)
 	{
-		// Elapsed time since we started ItemInterpTimer
-		const float ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
-		// Get curve value corresponding to ElapsedTime
-		const float CurveValue = ItemZCurve->GetFloatValue(ElapsedTime);
-		// Get the item initial location when curve started
-		FVector ItemLocation = ItemInterpStartLocation;
-		// Get location infront of the camera
-		const FVector CameraInterpLocation{ Character->GetCameraInterpLocation() };
-		// Vector from Item to Camera Interp Location, X and Y are zeroed up
-		const FVector ItemToCamera{ FVector(0.f, 0.f, (CameraInterpLocation - ItemLocation).Z) };
-		// Scale factor to multiple with CurveValue
-		const float DeltaZ = ItemToCamera.Size();
-
-		const FVector CurrentLocation{ GetActorLocation() };
-		// Interpolated X value
-		const float InterpXValue = FMath::FInterpTo(CurrentLocation.X, CameraInterpLocation.X, DeltaTime, 30.0f);
-		// Interpolated Y value
-		const float InterpYValue = FMath::FInterpTo(CurrentLocation.Y, CameraInterpLocation.Y, DeltaTime, 30.0f);
-
-		// Set X and Y of ItemLocation ot Interped value
-		ItemLocation.X = InterpXValue;
-		ItemLocation.Y = InterpYValue;
-
-		// Adding curve value to the Z component of the Initial Location (scaled by DeltaZ)
-		ItemLocation.Z += CurveValue * DeltaZ;
-		SetActorLocation(ItemLocation, true, nullptr, ETeleportType::TeleportPhysics);
-
-		// Camera rotation this frame
-		const FRotator CameraRotation{ Character->GetFollowCamera()->GetComponentRotation() };
-		// Camera rotation plus initial Yaw Offset
-		FRotator ItemRotation{ 0.f, CameraRotation.Yaw + InterpInitialYawOffset, 0.f };
-
-		SetActorRotation(ItemRotation, ETeleportType::TeleportPhysics);
-
-		if(ItemScaleCurve)
-		{
-			// Set item scale according to curve
-			const float ScaleCurveValue = ItemScaleCurve->GetFloatValue(ElapsedTime);
-			SetActorScale3D(FVector(ScaleCurveValue, ScaleCurveValue, ScaleCurveValue));
-		}
+		INC_DWORD_STAT(STAT_TickingItems);
+	}
+	else
+	{
+		DEC_DWORD_STAT(STAT_TickingItems);
 	}
 }
 
-// Called every frame
-void AItem::Tick(float DeltaTime)
+void AItem::SetItemCount(int32 Count)
 {
-	Super::Tick(DeltaTime);
+	if (Count == ItemCount) return;
 
-	ItemInterp(DeltaTime);
+	ItemCount = Count;
+	ItemCountChangedEvent.Broadcast(this);
 }
 
 void AItem::SetItemState(EItemState NewState)
 {
+	// BeginPlay sets up the initial state, after that only actual changes cost anything
+	if (NewState == ItemState && HasActorBegunPlay()) return;
+
 	ItemState = NewState;
 	SetItemProperties(NewState);
+
+	if (HasActorBegunPlay())
+	{
+		UpdateItemGrid();
+		UpdatePickupProxy();
+		OnItemStateChanged();
+	}
+
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::ItemState))
+	{
+		UShooterDiagnosticsSubsystem::DrawString(
+			this,
+			GetActorLocation() + FVector(0.f, 0.f, 50.f),
+			FString::Printf(TEXT("%s: %s"), *GetName(), *UEnum::GetDisplayValueAsText(NewState).ToString()),
+			FColor::Yellow,
+			2.f);
+	}
+#endif
+}
+
+void AItem::OnItemStateChanged()
+{
+}
+
+void AItem::UpdateItemGrid()
+{
+	if (UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>())
+	{
+		ItemGrid->UpdateItem(this);
+	}
+}
+
+void AItem::UpdatePickupProxy()
+{
+	UPickupProxySubsystem* PickupProxies = GetWorld()->GetSubsystem<UPickupProxySubsystem>();
+	const bool bUseProxy = PickupProxies && PickupProxies->UpdateItem(this);
+	if (bUseProxy == bUsingPickupProxy) return;
+
+	bUsingPickupProxy = bUseProxy;
+
+	// Nothing to pose or skin while the proxy stands in for the mesh
+	ItemMesh->bNoSkeletonUpdate = bUseProxy;
+	ItemMesh->SetComponentTickEnabled(!bUseProxy);
+	ItemMesh->SetVisibility(!bUseProxy);
+}
+
+void AItem::SetSignificance(ESignificance NewSignificance)
+{
+	Significance = NewSignificance;
+	SetActorTickInterval(USignificanceSubsystem::GetTickInterval(Significance));
+}
+
+void AItem::ResetPooledItem()
+{
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	if (bInterping)
+	{
+		if (UItemInterpSubsystem* ItemInterp = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+		{
+			ItemInterp->StopInterp(this);
+		}
+	}
+	bInterping = false;
+	Character = nullptr;
+	SetActorScale3D(FVector(1.f));
+	UpdateTickEnabled();
 }
 
 void AItem::StartItemCurve(AShooterCharacter* Char)
 {
 	// Store a handle to a Character
 	Character = Char;
-	// Store initial location of the item
-	ItemInterpStartLocation = GetActorLocation();
-	
+
 	bInterping = true;
 	SetItemState(EItemState::EIS_EquipInterping);
 
-	GetWorldTimerManager().SetTimer(ItemInterpTimer, this, &AItem::FinishInterping, ZCurveTime);
+	// The tier may be stale from lying around unrendered as a pickup proxy
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
+	{
+		SignificanceSubsystem->RefreshActor(this);
+	}
 
-	// Get initial Yaw of the Camera
-	const double CameraRotationYaw{ Character->GetFollowCamera()->GetComponentRotation().Yaw };
-	// Get initial Yaw of the Item
-	const double ItemRotationYaw{ GetActorRotation().Yaw };
-	// Initial Yaw offset between Camera and Item
-	InterpInitialYawOffset = ItemRotationYaw - CameraRotationYaw;
+	if (UItemInterpSubsystem* ItemInterp = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+	{
+		ItemInterp->StartInterp(this, Character);
+	}
+	else
+	{
+		// Nothing to fly the item to the camera, hand it over right away
+		FinishInterping();
+	}
 }
 
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs ItemStateBenchmarkCommand(
+	TEXT("Shooter.Bench.ItemStates"),
+	TEXT("Spawn items and measure the cost of moving them through every item state.\n")
+	TEXT("Usage: Shooter.Bench.ItemStates [Items=256] [Cycles=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr) return;
+
+		const int32 NumItems = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 256;
+		const int32 NumCycles = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+
+		// Far below the level, falling items have nothing to land on
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		TArray<AItem*> Items;
+		for (int32 Index = 0; Index < NumItems; ++Index)
+		{
+			const FVector Location{ (Index % 64) * 200.f, (Index / 64) * 200.f, -100'000.f };
+			if (AItem* Item = World->SpawnActor<AItem>(AItem::StaticClass(), FTransform(Location), SpawnParameters))
+			{
+				Items.Add(Item);
+			}
+		}
+
+		// The way a weapon goes round: picked up, equiped, dropped, lands
+		const EItemState Transitions[] =
+		{
+			EItemState::EIS_EquipInterping,
+			EItemState::EIS_Equiped,
+			EItemState::EIS_Falling,
+			EItemState::EIS_Pickup,
+		};
+
+		constexpr int32 NumTransitions = UE_ARRAY_COUNT(Transitions);
+
+		uint64 TransitionCycles[NumTransitions] = {};
+		uint64 UnchangedCycles = 0;
+		for (int32 Cycle = 0; Cycle < NumCycles; ++Cycle)
+		{
+			for (int32 Transition = 0; Transition < NumTransitions; ++Transition)
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				for (AItem* Item : Items)
+				{
+					Item->SetItemState(Transitions[Transition]);
+				}
+				TransitionCycles[Transition] += FPlatformTime::Cycles64() - StartCycles;
+
+				// Setting the state an item is already in should be close to free
+				const uint64 UnchangedStartCycles = FPlatformTime::Cycles64();
+				for (AItem* Item : Items)
+				{
+					Item->SetItemState(Transitions[Transition]);
+				}
+				UnchangedCycles += FPlatformTime::Cycles64() - UnchangedStartCycles;
+			}
+		}
+
+		const double NumSamples = static_cast<double>(Items.Num()) * NumCycles;
+		UE_LOG(LogUltimateShooter, Log, TEXT("Item state benchmark: %d items, %d cycles"), Items.Num(), NumCycles);
+		for (int32 Transition = 0; Transition < NumTransitions; ++Transition)
+		{
+			UE_LOG(LogUltimateShooter, Log, TEXT("    -> %-16s %8.3f us per item"),
+				*UEnum::GetDisplayValueAsText(Transitions[Transition]).ToString(),
+				FPlatformTime::ToMilliseconds64(TransitionCycles[Transition]) * 1000.0 / NumSamples);
+		}
+		UE_LOG(LogUltimateShooter, Log, TEXT("    unchanged          %8.3f us per item"),
+			FPlatformTime::ToMilliseconds64(UnchangedCycles) * 1000.0 / (NumSamples * NumTransitions));
+
+		for (AItem* Item : Items)
+		{
+			Item->Destroy();
+		}
+	}));
+
+#endif
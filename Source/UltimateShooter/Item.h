@@ -4,19 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "ItemDefinition.h"
+#include "SignificanceSubsystem.h"
 #include "Item.generated.h"
 
-UENUM(BlueprintType)
-enum class EItemRarity : uint8
-{
-	EIR_Damaged UMETA(DisplayName = "Damaged"),
-	EIR_Common UMETA(DisplayName = "Common"),
-	EIR_Uncommon UMETA(DisplayName = "Uncommon"),
-	EIR_Rare UMETA(DisplayName = "Rare"),
-	EIR_Legendary UMETA(DisplayName = "Legendary"),
-	EIR_MAX UMETA(DisplayName = "DefaultMAX")
-};
-
 UENUM(BlueprintType)
 enum class EItemState : uint8
 {
@@ -25,10 +16,16 @@ enum class EItemState : uint8
 	EIS_PickedUp UMETA(DisplayName = "PickedUp"),
 	EIS_Equiped UMETA(DisplayName = "Equiped"),
 	EIS_Falling UMETA(DisplayName = "Falling"),
+	EIS_Parked UMETA(DisplayName = "Parked"),
 	
 	EIS_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
+class AItem;
+
+/* Broadcast when an item's ItemCount changes, e.g. when an ammo box absorbs another */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnItemCountChanged, AItem* /* Item */);
+
 UCLASS()
 class ULTIMATESHOOTER_API AItem : public AActor
 {
@@ -38,38 +35,45 @@ public:
 	// Sets default values for this actor's properties
 	AItem();
 
+#if WITH_EDITOR
+	/* Builds a definition from the deprecated properties of items saved before definitions existed */
+	virtual void PostLoad() override;
+#endif
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	/* Called when overlapping AreaSphere */
-	UFUNCTION()
-	void OnSphereOverlap(
-		UPrimitiveComponent* OverlappedComponent,
-		AActor* OtherActor, 
-		UPrimitiveComponent* OtherCompo, 
-		int32 OtherBodyIndex, 
-		bool bFromSweep, 
-		const FHitResult& SweepResult);
-
-	/* Called when end overlapping AreaSphere */
-	UFUNCTION()
-	void OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
-
-	/* Sets active starts based on rarity */
-	void SetActiveStars();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/* Sets properties of the Item's component base on State */
 	void SetItemProperties(EItemState State);
 
-	/* Called when ItemInterpTimer is finished */
-	void FinishInterping();
+	/* True while Tick has work to do, items only tick on demand. Interpolation runs in UItemInterpSubsystem */
+	virtual bool NeedsTick() const;
 
-	/* Handle item interpolation when in the EquipInterping state */
-	void ItemInterp(float DeltaTime);
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	/* Turn Tick on or off to match NeedsTick */
+	void UpdateTickEnabled();
+
+	/* Add, move or remove the item in the world's item grid to match its state and location */
+	void UpdateItemGrid();
+
+	/* Swap between the skeletal item mesh and a static pickup proxy to match the item's state */
+	void UpdatePickupProxy();
+
+	/* Called by USignificanceSubsystem when the item changes tier */
+	void SetSignificance(ESignificance NewSignificance);
+
+	/* Called once BeginPlay has set up the initial state and after every state change from then on */
+	virtual void OnItemStateChanged();
+
+#if WITH_EDITOR
+	/* Definition a definition built from deprecated properties starts out as, also decides its class */
+	virtual const UItemDefinition* GetMigrationTemplate() const;
+
+	/* Copy the deprecated properties that differ from Archetype's into Migrated, true if there were any */
+	virtual bool MigrateDeprecatedProperties(const AItem& Archetype, UItemDefinition& Migrated) const;
+#endif
 
 private:
 	/* Skeletal mesh for the item */
@@ -80,41 +84,18 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
 	class UBoxComponent* CollisionBox;
 
-	/* Popup widget for when the player looks at the item */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
-	class UWidgetComponent* PickupWidget;
-
-	/* Enables item tracing when overlaped */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
-	class USphereComponent* AreaSphere;
-
-	/* The name which appears on the Pickup Widget */
+	/* Properties shared with every other item of this kind, the class default definition when not set */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
-	FString ItemName;
+	UItemDefinition* Definition;
 
 	/* Item count (ammo, etc.) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
 	int32 ItemCount;
 
-	/* Item rarity - determins number of stars in Pickup Widget */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
-	EItemRarity ItemRarity;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
-	TArray<bool> ActiveStars;
-
 	/* State if the item */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
 	EItemState ItemState;
 
-	/* The curve asset to use for item's Z location when interping */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	class UCurveFloat* ItemZCurve;
-
-	/* Starting location when interping begins */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	FVector ItemInterpStartLocation;
-
 	/* Target interp location infront of the camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
 	FVector CameraTargetLocation;
@@ -123,48 +104,77 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
 	bool bInterping;
 
-	/* Plays when we start interping */
-	FTimerHandle ItemInterpTimer;
-
 	/* Pinter to the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
 	class AShooterCharacter* Character;
 
-	/* Duration of the curve and timer */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	float ZCurveTime;
-
 	/* X and Y for the Item while interpin in the EquipedInterping state */
 	float ItemInterpX;
 	float ItemInterpY;
 
-	/* Initial Yaw offset between the camera and the interping item */
-	double InterpInitialYawOffset;
+	/* True while a UPickupProxySubsystem instance draws the item instead of ItemMesh */
+	bool bUsingPickupProxy;
+
+	/* Tier the significance subsystem last put the item in */
+	ESignificance Significance;
+
+	FOnItemCountChanged ItemCountChangedEvent;
 
-	/* Curve used to scale item when interping */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	UCurveFloat* ItemScaleCurve;
+#if WITH_EDITORONLY_DATA
+	/* Properties items held before they moved to UItemDefinition, only loaded to build a definition from, see PostLoad */
+	UPROPERTY()
+	FString ItemName_DEPRECATED;
 
-	/* Should played when Item is picked up */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	class USoundCue* PickupSound;
+	UPROPERTY()
+	EItemRarity ItemRarity_DEPRECATED;
 
-	/* Sound played when Item is equiped */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item properties", meta = (AllowPrivateAccess = "True"))
-	class USoundCue* EquipSound;
+	UPROPERTY()
+	UCurveFloat* ItemZCurve_DEPRECATED;
+
+	UPROPERTY()
+	UCurveFloat* ItemScaleCurve_DEPRECATED;
+
+	UPROPERTY()
+	float ZCurveTime_DEPRECATED;
+
+	UPROPERTY()
+	USoundCue* PickupSound_DEPRECATED;
+
+	UPROPERTY()
+	USoundCue* EquipSound_DEPRECATED;
+
+	/* Sphere that used to switch item tracing on, kept so the radius set on it carries over to the definition's PickupRadius */
+	UPROPERTY()
+	class USphereComponent* AreaSphere_DEPRECATED;
+#endif
 public:
-	FORCEINLINE UWidgetComponent* GetPickupWidget() const { return PickupWidget; };
-	FORCEINLINE USphereComponent* GetAreaSphere() const { return AreaSphere; }
+	FORCEINLINE const UItemDefinition* GetDefinition() const { return Definition ? Definition : GetDefault<UItemDefinition>(); }
+
+	FORCEINLINE const FVector& GetPickupWidgetOffset() const { return GetDefinition()->GetPickupWidgetOffset(); }
+	FORCEINLINE const FString& GetItemName() const { return GetDefinition()->GetItemName(); }
+	FORCEINLINE int32 GetItemCount() const { return ItemCount; }
+	void SetItemCount(int32 Count);
+
+	/* Fired by SetItemCount when the count actually changes */
+	FORCEINLINE FOnItemCountChanged& OnItemCountChanged() { return ItemCountChangedEvent; }
+	FORCEINLINE float GetPickupRadius() const { return GetDefinition()->GetPickupRadius(); }
 	FORCEINLINE UBoxComponent* GetCollisionBox() const { return CollisionBox; }
 	FORCEINLINE EItemState GetItemState() const { return ItemState; }
+	FORCEINLINE ESignificance GetSignificance() const { return Significance; }
 
 	void SetItemState(EItemState NewState);
 
 	FORCEINLINE USkeletalMeshComponent* GetItemMesh() const { return ItemMesh; }
 
-	FORCEINLINE USoundCue* GetPickupSound() const { return PickupSound; }
-	FORCEINLINE USoundCue* GetEquipSound() const { return EquipSound; }
+	FORCEINLINE USoundCue* GetPickupSound() const { return GetDefinition()->GetPickupSound(); }
+	FORCEINLINE USoundCue* GetEquipSound() const { return GetDefinition()->GetEquipSound(); }
 
 	/* Called from AShooter character class */
 	void StartItemCurve(AShooterCharacter* Char);
+
+	/* Called by UItemInterpSubsystem once the item has reached the character */
+	void FinishInterping();
+
+	/* Drop pending timers and interpolation so a pooled item comes back clean, see UItemPoolSubsystem */
+	virtual void ResetPooledItem();
 };
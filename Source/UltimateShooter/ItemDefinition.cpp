@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemDefinition.h"
+#include "Curves/CurveFloat.h"
+#include "Sound/SoundCue.h"
+
+const FPrimaryAssetType UItemDefinition::PrimaryAssetType(TEXT("ItemDefinition"));
+
+UItemDefinition::UItemDefinition() :
+	ItemName(FString("Default")),
+	ItemRarity(EItemRarity::EIR_Common),
+	PickupWidgetOffset(FVector(0.f, 0.f, 50.f)),
+	PickupRadius(150.f),
+	PickupMesh(nullptr),
+	ZCurveTime(0.7f)
+{
+}
+
+FPrimaryAssetId UItemDefinition::GetPrimaryAssetId() const
+{
+	// Weapon definitions are looked up together with every other item
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void UItemDefinition::GetActiveStars(TArray<bool>& OutActiveStars) const
+{
+	OutActiveStars.Init(false, 6);
+
+	int32 ItemRarityStarsAmount;
+	switch (ItemRarity)
+	{
+	case EItemRarity::EIR_Damaged:
+		ItemRarityStarsAmount = 1;
+		break;
+	case EItemRarity::EIR_Common:
+		ItemRarityStarsAmount = 2;
+		break;
+	case EItemRarity::EIR_Uncommon:
+		ItemRarityStarsAmount = 3;
+		break;
+	case EItemRarity::EIR_Rare:
+		ItemRarityStarsAmount = 4;
+		break;
+	case EItemRarity::EIR_Legendary:
+		ItemRarityStarsAmount = 5;
+		break;
+	case EItemRarity::EIR_MAX:
+		ItemRarityStarsAmount = 5;
+		break;
+	default:
+		ItemRarityStarsAmount = 0;
+		break;
+	}
+	for (int32 i = 1; i <= ItemRarityStarsAmount; i++) {
+		OutActiveStars[i] = true;
+	}
+}
+
+void UItemDefinition::GetStreamedAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	OutAssets.Add(ItemZCurve.ToSoftObjectPath());
+	OutAssets.Add(ItemScaleCurve.ToSoftObjectPath());
+	OutAssets.Add(PickupSound.ToSoftObjectPath());
+	OutAssets.Add(EquipSound.ToSoftObjectPath());
+}
+
+UCurveFloat* UItemDefinition::GetItemZCurve() const
+{
+	return ItemZCurve.Get();
+}
+
+UCurveFloat* UItemDefinition::GetItemScaleCurve() const
+{
+	return ItemScaleCurve.Get();
+}
+
+USoundCue* UItemDefinition::GetPickupSound() const
+{
+	return PickupSound.Get();
+}
+
+USoundCue* UItemDefinition::GetEquipSound() const
+{
+	return EquipSound.Get();
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ItemDefinition.generated.h"
+
+class UCurveFloat;
+class USoundCue;
+class UStaticMesh;
+
+UENUM(BlueprintType)
+enum class EItemRarity : uint8
+{
+	EIR_Damaged UMETA(DisplayName = "Damaged"),
+	EIR_Common UMETA(DisplayName = "Common"),
+	EIR_Uncommon UMETA(DisplayName = "Uncommon"),
+	EIR_Rare UMETA(DisplayName = "Rare"),
+	EIR_Legendary UMETA(DisplayName = "Legendary"),
+	EIR_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * Properties every item of one kind has in common. Items point at one shared definition
+ * and only hold their own state, see AItem::GetDefinition
+ */
+UCLASS(BlueprintType)
+class ULTIMATESHOOTER_API UItemDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+	/* Builds definitions from the properties items saved before definitions existed, see AItem::PostLoad */
+	friend class AItem;
+
+public:
+	UItemDefinition();
+
+	/* Primary asset type shared by item definitions and all their subclasses */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/* Fill OutActiveStars with one flag per star of the Pickup Widget, index 0 is unused */
+	void GetActiveStars(TArray<bool>& OutActiveStars) const;
+
+	/* Add the assets UAssetStreamingSubsystem streams in before items of this kind are used */
+	virtual void GetStreamedAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
+private:
+	/* The name which appears on the Pickup Widget */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	FString ItemName;
+
+	/* Item rarity - determins number of stars in Pickup Widget */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	EItemRarity ItemRarity;
+
+	/* Where the character's pickup widget is placed relative to the item when the player looks at it */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	FVector PickupWidgetOffset;
+
+	/* Characters this close trace for items, see UItemGridSubsystem */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+	float PickupRadius;
+
+	/* Static stand in for the item mesh while the item lies in the world, see UPickupProxySubsystem. Pivot has to match the item mesh */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	UStaticMesh* PickupMesh;
+
+	/* The curve asset to use for item's Z location when interping */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<UCurveFloat> ItemZCurve;
+
+	/* Curve used to scale item when interping */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<UCurveFloat> ItemScaleCurve;
+
+	/* Duration of the curve and timer */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	float ZCurveTime;
+
+	/* Should played when Item is picked up */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundCue> PickupSound;
+
+	/* Sound played when Item is equiped */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundCue> EquipSound;
+public:
+	FORCEINLINE const FString& GetItemName() const { return ItemName; }
+	FORCEINLINE EItemRarity GetItemRarity() const { return ItemRarity; }
+	FORCEINLINE const FVector& GetPickupWidgetOffset() const { return PickupWidgetOffset; }
+	FORCEINLINE float GetPickupRadius() const { return PickupRadius; }
+	FORCEINLINE UStaticMesh* GetPickupMesh() const { return PickupMesh; }
+	FORCEINLINE float GetZCurveTime() const { return ZCurveTime; }
+
+	/* Streamed assets, null until loaded */
+	UCurveFloat* GetItemZCurve() const;
+	UCurveFloat* GetItemScaleCurve() const;
+	USoundCue* GetPickupSound() const;
+	USoundCue* GetEquipSound() const;
+};
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemGridSubsystem.h"
+#include "UltimateShooter.h"
+#include "Item.h"
+
+static TAutoConsoleVariable<float> CVarItemGridCellSize(
+	TEXT("Shooter.ItemGrid.CellSize"),
+	500.f,
+	TEXT("Size of the item grid cells in cm. Read when a world starts."),
+	ECVF_ReadOnly);
+
+DECLARE_CYCLE_STAT(TEXT("Item Grid Query"), STAT_ItemGridQuery, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item Grid Items"), STAT_ItemGridItems, STATGROUP_UltimateShooter);
+
+FItemSpatialHash::FItemSpatialHash(float InCellSize) :
+	CellSize(FMath::Max(InCellSize, 1.f)),
+	InvCellSize(1.f / CellSize),
+	MaxRadius(0.f)
+{
+}
+
+void FItemSpatialHash::Update(int32 Id, const FVector& Location, float Radius)
+{
+	MaxRadius = FMath::Max(MaxRadius, Radius);
+
+	const FIntPoint NewCell{ GetCell(Location.X, Location.Y) };
+	if (FIntPoint* OldCell = EntryCells.Find(Id))
+	{
+		if (*OldCell == NewCell)
+		{
+			// Same bucket, update in place
+			for (FEntry& Entry : Cells.FindChecked(NewCell))
+			{
+				if (Entry.Id == Id)
+				{
+					Entry.Location = FVector3f(Location);
+					Entry.Radius = Radius;
+					return;
+				}
+			}
+		}
+		Remove(Id);
+	}
+
+	Cells.FindOrAdd(NewCell).Add({ Id, FVector3f(Location), Radius });
+	EntryCells.Add(Id, NewCell);
+}
+
+void FItemSpatialHash::Remove(int32 Id)
+{
+	FIntPoint Cell;
+	if (!EntryCells.RemoveAndCopyValue(Id, Cell)) return;
+
+	TArray<FEntry>& Entries = Cells.FindChecked(Cell);
+	const int32 Index = Entries.IndexOfByPredicate([Id](const FEntry& Entry) { return Entry.Id == Id; });
+	Entries.RemoveAtSwap(Index, 1, false);
+	if (Entries.Num() == 0)
+	{
+		Cells.Remove(Cell);
+	}
+}
+
+void FItemSpatialHash::Reset()
+{
+	Cells.Reset();
+	EntryCells.Reset();
+	MaxRadius = 0.f;
+}
+
+bool FItemSpatialHash::AnyInRange(const FVector& Location, float Radius) const
+{
+	const FVector3f QueryLocation{ Location };
+	bool bFound = false;
+	ForEachCandidate(Location, Radius, [&](const FEntry& Entry)
+	{
+		bFound = FVector3f::DistSquared(QueryLocation, Entry.Location) <= FMath::Square(Entry.Radius + Radius);
+		return !bFound;
+	});
+	return bFound;
+}
+
+UItemGridSubsystem::UItemGridSubsystem() :
+	Revision(0)
+{
+}
+
+bool UItemGridSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UItemGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid = FItemSpatialHash(CVarItemGridCellSize.GetValueOnGameThread());
+}
+
+void UItemGridSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_ItemGridItems, Grid.Num());
+
+	Grid.Reset();
+	Items.Empty();
+	ItemIds.Empty();
+	FreeIds.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemGridSubsystem::UpdateItem(AItem* Item)
+{
+	if (Item == nullptr) return;
+
+	if (Item->GetItemState() != EItemState::EIS_Pickup)
+	{
+		RemoveItem(Item);
+		return;
+	}
+
+	int32 Id = INDEX_NONE;
+	if (const int32* ExistingId = ItemIds.Find(Item))
+	{
+		Id = *ExistingId;
+	}
+	else
+	{
+		Id = FreeIds.Num() > 0 ? FreeIds.Pop(false) : Items.AddDefaulted();
+		Items[Id] = Item;
+		ItemIds.Add(Item, Id);
+		INC_DWORD_STAT(STAT_ItemGridItems);
+	}
+	Grid.Update(Id, Item->GetActorLocation(), Item->GetPickupRadius());
+	++Revision;
+}
+
+void UItemGridSubsystem::RemoveItem(AItem* Item)
+{
+	int32 Id = INDEX_NONE;
+	if (!ItemIds.RemoveAndCopyValue(Item, Id)) return;
+
+	Grid.Remove(Id);
+	Items[Id] = nullptr;
+	FreeIds.Add(Id);
+	DEC_DWORD_STAT(STAT_ItemGridItems);
+	++Revision;
+}
+
+bool UItemGridSubsystem::IsNearItem(const FVector& Location, float Radius) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemGridQuery);
+
+	return Grid.AnyInRange(Location, Radius);
+}
+
+void UItemGridSubsystem::GetItemsInRange(const FVector& Location, float Radius, TArray<AItem*>& OutItems) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemGridQuery);
+
+	OutItems.Reset();
+	Grid.ForEachInRange(Location, Radius, [this, &OutItems](int32 Id)
+	{
+		OutItems.Add(Items[Id]);
+	});
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand ItemGridBenchmarkCommand(
+	TEXT("Shooter.Bench.ItemGrid"),
+	TEXT("Compare finding the items near a player with the item grid and with a test against every item.\n")
+	TEXT("Usage: Shooter.Bench.ItemGrid [Items=10000] [Queries=10000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumItems = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10'000;
+		const int32 NumQueries = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10'000;
+
+		// Items scattered over a 1km square, roughly one every 10m
+		const float WorldExtent = 50'000.f;
+		const float PickupRadius = 150.f;
+		const float PlayerRadius = 40.f;
+
+		FRandomStream Random(1337);
+		auto RandomLocation = [&Random, WorldExtent]()
+		{
+			return FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(0.f, 500.f));
+		};
+
+		TArray<FVector> ItemLocations;
+		ItemLocations.Reserve(NumItems);
+		for (int32 Index = 0; Index < NumItems; ++Index)
+		{
+			ItemLocations.Add(RandomLocation());
+		}
+
+		TArray<FVector> QueryLocations;
+		QueryLocations.Reserve(NumQueries);
+		for (int32 Index = 0; Index < NumQueries; ++Index)
+		{
+			QueryLocations.Add(RandomLocation());
+		}
+
+		FItemSpatialHash Grid(CVarItemGridCellSize.GetValueOnGameThread());
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < NumItems; ++Index)
+		{
+			Grid.Update(Index, ItemLocations[Index], PickupRadius);
+		}
+		const double InsertMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		// Every item dropped and picked up again somewhere else
+		for (FVector& ItemLocation : ItemLocations)
+		{
+			ItemLocation = RandomLocation();
+		}
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < NumItems; ++Index)
+		{
+			Grid.Update(Index, ItemLocations[Index], PickupRadius);
+		}
+		const double MoveMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		int32 GridHits = 0;
+		StartCycles = FPlatformTime::Cycles64();
+		for (const FVector& QueryLocation : QueryLocations)
+		{
+			GridHits += Grid.AnyInRange(QueryLocation, PlayerRadius) ? 1 : 0;
+		}
+		const double GridQueryMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		// What per item overlap spheres amount to, every item tested against every player
+		int32 BruteForceHits = 0;
+		StartCycles = FPlatformTime::Cycles64();
+		for (const FVector& QueryLocation : QueryLocations)
+		{
+			for (const FVector& ItemLocation : ItemLocations)
+			{
+				if (FVector::DistSquared(QueryLocation, ItemLocation) <= FMath::Square(PickupRadius + PlayerRadius))
+				{
+					++BruteForceHits;
+					break;
+				}
+			}
+		}
+		const double BruteForceQueryMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		UE_LOG(LogUltimateShooter, Log, TEXT("Item grid benchmark: %d items in %d cells of %.0fcm, %d queries"),
+			NumItems, Grid.GetNumCells(), Grid.GetCellSize(), NumQueries);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    insert      %8.3f ms (%.3f us per item)"), InsertMs, InsertMs * 1000.0 / NumItems);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    move        %8.3f ms (%.3f us per item)"), MoveMs, MoveMs * 1000.0 / NumItems);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    grid query  %8.3f ms (%.3f us per query, %d near items)"), GridQueryMs, GridQueryMs * 1000.0 / NumQueries, GridHits);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    brute force %8.3f ms (%.3f us per query, %d near items)"), BruteForceQueryMs, BruteForceQueryMs * 1000.0 / NumQueries, BruteForceHits);
+	}));
+
+#endif
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemGridSubsystem.generated.h"
+
+class AItem;
+
+/**
+ * Uniform grid over the XY plane holding points with a reach radius, bucketed by the cell their point is in.
+ * Range queries visit the cells within the query radius plus the largest reach, so entries are found
+ * without testing every entry, and entries only move between buckets when they cross a cell border.
+ */
+class ULTIMATESHOOTER_API FItemSpatialHash
+{
+public:
+	explicit FItemSpatialHash(float InCellSize = 500.f);
+
+	/* Add Id at Location, or move it there if it is already in the grid */
+	void Update(int32 Id, const FVector& Location, float Radius);
+
+	/* Remove Id, does nothing if it isn't in the grid */
+	void Remove(int32 Id);
+
+	/* Remove everything */
+	void Reset();
+
+	/* Call Functor(Id) for every entry whose radius reaches within Radius of Location */
+	template<typename FunctorType>
+	void ForEachInRange(const FVector& Location, float Radius, FunctorType&& Functor) const;
+
+	/* True if any entry's radius reaches within Radius of Location */
+	bool AnyInRange(const FVector& Location, float Radius) const;
+
+	FORCEINLINE bool Contains(int32 Id) const { return EntryCells.Contains(Id); }
+	FORCEINLINE int32 Num() const { return EntryCells.Num(); }
+	FORCEINLINE int32 GetNumCells() const { return Cells.Num(); }
+	FORCEINLINE float GetCellSize() const { return CellSize; }
+
+private:
+	struct FEntry
+	{
+		int32 Id;
+		FVector3f Location;
+		float Radius;
+	};
+
+	FORCEINLINE FIntPoint GetCell(double X, double Y) const
+	{
+		return FIntPoint(FMath::FloorToInt32(X * InvCellSize), FMath::FloorToInt32(Y * InvCellSize));
+	}
+
+	/* Calls Functor(Entry) for entries in the cells a query around Location has to visit, until it returns false */
+	template<typename FunctorType>
+	void ForEachCandidate(const FVector& Location, float Radius, FunctorType&& Functor) const;
+
+	float CellSize;
+	float InvCellSize;
+
+	/* Largest radius ever added, how far past the query radius cells have to be visited */
+	float MaxRadius;
+
+	TMap<FIntPoint, TArray<FEntry>> Cells;
+
+	/* Cell each entry is bucketed in */
+	TMap<int32, FIntPoint> EntryCells;
+};
+
+template<typename FunctorType>
+void FItemSpatialHash::ForEachCandidate(const FVector& Location, float Radius, FunctorType&& Functor) const
+{
+	const double Reach = Radius + MaxRadius;
+	const FIntPoint MinCell{ GetCell(Location.X - Reach, Location.Y - Reach) };
+	const FIntPoint MaxCell{ GetCell(Location.X + Reach, Location.Y + Reach) };
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			const TArray<FEntry>* Cell = Cells.Find(FIntPoint(CellX, CellY));
+			if (Cell == nullptr) continue;
+
+			for (const FEntry& Entry : *Cell)
+			{
+				if (!Functor(Entry)) return;
+			}
+		}
+	}
+}
+
+template<typename FunctorType>
+void FItemSpatialHash::ForEachInRange(const FVector& Location, float Radius, FunctorType&& Functor) const
+{
+	const FVector3f QueryLocation{ Location };
+	ForEachCandidate(Location, Radius, [&](const FEntry& Entry)
+	{
+		if (FVector3f::DistSquared(QueryLocation, Entry.Location) <= FMath::Square(Entry.Radius + Radius))
+		{
+			Functor(Entry.Id);
+		}
+		return true;
+	});
+}
+
+/**
+ * Registry of every item lying in the world in the pickup state, kept in a spatial hash.
+ * Items update their own entry when they change state, characters query it to find out
+ * whether any item is close enough to trace for.
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UItemGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UItemGridSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/* Add Item at its current location if it is in the pickup state, remove it otherwise */
+	void UpdateItem(AItem* Item);
+
+	/* Remove Item from the grid */
+	void RemoveItem(AItem* Item);
+
+	/* True if Location is within the pickup radius of any item, Radius is added to the item's */
+	bool IsNearItem(const FVector& Location, float Radius) const;
+
+	/* Items whose pickup radius reaches within Radius of Location */
+	void GetItemsInRange(const FVector& Location, float Radius, TArray<AItem*>& OutItems) const;
+
+	FORCEINLINE int32 GetNumItems() const { return Grid.Num(); }
+
+	/* Changes whenever an item is added, moved or removed, lets queries that found nothing new skip running again */
+	FORCEINLINE uint32 GetRevision() const { return Revision; }
+
+private:
+	FItemSpatialHash Grid;
+
+	uint32 Revision;
+
+	/* Items by grid id, null in free slots */
+	UPROPERTY()
+	TArray<AItem*> Items;
+
+	/* Grid id of every registered item */
+	TMap<const AItem*, int32> ItemIds;
+
+	/* Free slots in Items */
+	TArray<int32> FreeIds;
+};
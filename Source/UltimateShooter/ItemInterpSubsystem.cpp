@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemInterpSubsystem.h"
+#include "UltimateShooter.h"
+#include "Item.h"
+#include "ShooterCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Item Interp Update"), STAT_ItemInterpUpdate, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Interping Items"), STAT_InterpingItems, STATGROUP_UltimateShooter);
+
+FCurveLUT::FCurveLUT(const UCurveFloat* Curve)
+{
+	float MaxTime;
+	Curve->GetTimeRange(MinTime, MaxTime);
+	SampleRate = (NumSamples - 1) / FMath::Max(MaxTime - MinTime, KINDA_SMALL_NUMBER);
+
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Samples[Index] = Curve->GetFloatValue(MinTime + Index / SampleRate);
+	}
+}
+
+float FCurveLUT::Evaluate(float Time) const
+{
+	const float Position = FMath::Clamp((Time - MinTime) * SampleRate, 0.f, static_cast<float>(NumSamples - 1));
+	const int32 Index = FMath::Min(FMath::FloorToInt(Position), NumSamples - 2);
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], Position - Index);
+}
+
+bool UItemInterpSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UItemInterpSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_InterpingItems, Entries.Num());
+	Entries.Empty();
+	FinishedItems.Empty();
+	CurveLUTs.Empty();
+	CurveIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemInterpSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Entries.Num() == 0) return;
+
+	UpdateInterps(DeltaTime);
+	FinishInterps();
+}
+
+TStatId UItemInterpSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemInterpSubsystem, STATGROUP_Tickables);
+}
+
+void UItemInterpSubsystem::StartInterp(AItem* Item, AShooterCharacter* Character)
+{
+	if (Item == nullptr || Character == nullptr) return;
+
+	StopInterp(Item);
+
+	FItemInterpEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Item = Item;
+	Entry.Character = Character;
+	Entry.StartLocation = Item->GetActorLocation();
+	Entry.InitialYawOffset = Item->GetActorRotation().Yaw - Character->GetFollowCamera()->GetComponentRotation().Yaw;
+	Entry.StartTime = GetWorld()->GetTimeSeconds();
+	Entry.Duration = Item->GetDefinition()->GetZCurveTime();
+	Entry.ZCurveIndex = FindOrBakeCurve(Item->GetDefinition()->GetItemZCurve());
+	Entry.ScaleCurveIndex = FindOrBakeCurve(Item->GetDefinition()->GetItemScaleCurve());
+	INC_DWORD_STAT(STAT_InterpingItems);
+}
+
+void UItemInterpSubsystem::StopInterp(AItem* Item)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Item](const FItemInterpEntry& Entry) { return Entry.Item == Item; });
+	if (Index == INDEX_NONE) return;
+
+	Entries.RemoveAtSwap(Index, 1, false);
+	DEC_DWORD_STAT(STAT_InterpingItems);
+}
+
+void UItemInterpSubsystem::UpdateInterps(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemInterpUpdate);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	CharacterViews.Reset();
+
+	// Entries whose time is up are compacted out as we go
+	int32 NumKept = 0;
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		const FItemInterpEntry& Entry = Entries[Index];
+		AItem* Item = Entry.Item;
+		if (!IsValid(Item)) continue;
+
+		const float ElapsedTime = static_cast<float>(Now - Entry.StartTime);
+		if (ElapsedTime >= Entry.Duration || !IsValid(Entry.Character))
+		{
+			FinishedItems.Add(Item);
+			continue;
+		}
+
+		if (NumKept != Index)
+		{
+			Entries[NumKept] = Entry;
+		}
+		++NumKept;
+
+		// Nobody is close enough to watch, the item just arrives when its time is up
+		if (Item->GetSignificance() == ESignificance::ES_Minimal) continue;
+
+		// Camera target once per character, however many items it is picking up
+		FCharacterView* View = CharacterViews.FindByPredicate([&Entry](const FCharacterView& CharacterView) { return CharacterView.Character == Entry.Character; });
+		if (View == nullptr)
+		{
+			View = &CharacterViews.Add_GetRef({
+				Entry.Character,
+				Entry.Character->GetCameraInterpLocation(),
+				Entry.Character->GetFollowCamera()->GetComponentRotation().Yaw
+			});
+		}
+
+		// X and Y ease towards the camera target, Z follows the curve scaled by the height left to cover
+		FVector ItemLocation = Entry.StartLocation;
+		const double DeltaZ = FMath::Abs(View->InterpLocation.Z - ItemLocation.Z);
+		const FVector CurrentLocation{ Item->GetActorLocation() };
+		ItemLocation.X = FMath::FInterpTo(CurrentLocation.X, View->InterpLocation.X, DeltaTime, 30.0f);
+		ItemLocation.Y = FMath::FInterpTo(CurrentLocation.Y, View->InterpLocation.Y, DeltaTime, 30.0f);
+		if (Entry.ZCurveIndex != INDEX_NONE)
+		{
+			ItemLocation.Z += CurveLUTs[Entry.ZCurveIndex].Evaluate(ElapsedTime) * DeltaZ;
+		}
+
+		const FRotator ItemRotation{ 0.f, View->CameraYaw + Entry.InitialYawOffset, 0.f };
+		const FVector ItemScale{ Entry.ScaleCurveIndex != INDEX_NONE ? FVector(CurveLUTs[Entry.ScaleCurveIndex].Evaluate(ElapsedTime)) : Item->GetActorScale3D() };
+
+		// Flies through everything on its way to the camera, no sweep needed
+		Item->SetActorTransform(FTransform(ItemRotation, ItemLocation, ItemScale), false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	DEC_DWORD_STAT_BY(STAT_InterpingItems, Entries.Num() - NumKept);
+	Entries.SetNum(NumKept, false);
+}
+
+void UItemInterpSubsystem::FinishInterps()
+{
+	if (FinishedItems.Num() == 0) return;
+
+	// Picking an item up can start another interp, don't touch FinishedItems while that happens
+	TArray<AItem*> Items = MoveTemp(FinishedItems);
+	for (AItem* Item : Items)
+	{
+		if (IsValid(Item))
+		{
+			Item->FinishInterping();
+		}
+	}
+}
+
+int32 UItemInterpSubsystem::FindOrBakeCurve(const UCurveFloat* Curve)
+{
+	if (Curve == nullptr) return INDEX_NONE;
+
+	if (const int32* Index = CurveIndices.Find(Curve))
+	{
+		return *Index;
+	}
+
+	const int32 Index = CurveLUTs.Emplace(Curve);
+	CurveIndices.Add(Curve, Index);
+	return Index;
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs ItemInterpBenchmarkCommand(
+	TEXT("Shooter.Bench.ItemInterp"),
+	TEXT("Interp growing batches of items towards the first player's character and measure the cost per item.\n")
+	TEXT("Usage: Shooter.Bench.ItemInterp [Items=256] [Frames=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UItemInterpSubsystem* ItemInterp = World ? World->GetSubsystem<UItemInterpSubsystem>() : nullptr;
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		AShooterCharacter* Character = PlayerController ? Cast<AShooterCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (ItemInterp == nullptr || Character == nullptr)
+		{
+			UE_LOG(LogUltimateShooter, Warning, TEXT("Item interp benchmark needs a game world with a shooter character"));
+			return;
+		}
+
+		const int32 NumItems = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 256;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 60;
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		TArray<AItem*> Items;
+		for (int32 Index = 0; Index < NumItems; ++Index)
+		{
+			const FVector Location{ Character->GetActorLocation() + FVector((Index % 16) * 50.f, (Index / 16) * 50.f, 0.f) };
+			if (AItem* Item = World->SpawnActor<AItem>(AItem::StaticClass(), FTransform(Location), SpawnParameters))
+			{
+				Items.Add(Item);
+			}
+		}
+
+		// World time stands still during the command, nothing reaches the character and finishes
+		UE_LOG(LogUltimateShooter, Log, TEXT("Item interp benchmark: %d frames"), NumFrames);
+		for (int32 BatchSize = 1; BatchSize <= Items.Num(); BatchSize *= 2)
+		{
+			for (int32 Index = 0; Index < BatchSize; ++Index)
+			{
+				ItemInterp->StartInterp(Items[Index], Character);
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				ItemInterp->UpdateInterps(1.f / 60.f);
+			}
+			const double Milliseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+			UE_LOG(LogUltimateShooter, Log, TEXT("    %5d items %8.3f us per frame %8.3f us per item"),
+				BatchSize,
+				Milliseconds * 1000.0 / NumFrames,
+				Milliseconds * 1000.0 / (static_cast<double>(NumFrames) * BatchSize));
+
+			for (int32 Index = 0; Index < BatchSize; ++Index)
+			{
+				ItemInterp->StopInterp(Items[Index]);
+			}
+		}
+
+		for (AItem* Item : Items)
+		{
+			Item->Destroy();
+		}
+	}));
+
+#endif
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ItemInterpSubsystem.generated.h"
+
+class AItem;
+class AShooterCharacter;
+class UCurveFloat;
+
+/**
+ * A curve sampled at even steps over its time range. Evaluating it is a lerp between two samples
+ * instead of a key search, values outside the range clamp to the first/last sample
+ */
+class ULTIMATESHOOTER_API FCurveLUT
+{
+public:
+	static constexpr int32 NumSamples = 64;
+
+	explicit FCurveLUT(const UCurveFloat* Curve);
+
+	float Evaluate(float Time) const;
+
+private:
+	float MinTime;
+
+	/* Samples per second */
+	float SampleRate;
+
+	float Samples[NumSamples];
+};
+
+/* An item flying towards a character's camera */
+USTRUCT()
+struct FItemInterpEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AItem* Item = nullptr;
+
+	UPROPERTY()
+	AShooterCharacter* Character = nullptr;
+
+	/* Location when the interp started */
+	FVector StartLocation = FVector::ZeroVector;
+
+	/* Yaw offset between the camera and the item when the interp started */
+	double InitialYawOffset = 0.0;
+
+	/* World time the interp started at */
+	double StartTime = 0.0;
+
+	/* Seconds until the item reaches the character */
+	float Duration = 0.f;
+
+	/* Baked item curves in CurveLUTs, INDEX_NONE if the definition has none or it hasn't streamed in */
+	int32 ZCurveIndex = INDEX_NONE;
+	int32 ScaleCurveIndex = INDEX_NONE;
+};
+
+/**
+ * Moves every item that is being picked up in one pass per frame. The camera target is computed once
+ * per character, curves are read from baked lookup tables, and transforms are set without sweeping.
+ * Items are handed to their character once their interp time is up
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UItemInterpSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Start moving Item towards Character's camera for its definition's ZCurveTime */
+	void StartInterp(AItem* Item, AShooterCharacter* Character);
+
+	/* Stop moving Item without handing it to the character */
+	void StopInterp(AItem* Item);
+
+	/* Move every interping item, collecting the ones whose time is up */
+	void UpdateInterps(float DeltaTime);
+
+	/* Hand the items collected by UpdateInterps to their characters */
+	void FinishInterps();
+
+	FORCEINLINE int32 GetNumInterps() const { return Entries.Num(); }
+
+private:
+	/* Index into CurveLUTs of Curve's table, baking it on first use */
+	int32 FindOrBakeCurve(const UCurveFloat* Curve);
+
+	UPROPERTY()
+	TArray<FItemInterpEntry> Entries;
+
+	/* Items whose interp time is up, filled by UpdateInterps */
+	UPROPERTY()
+	TArray<AItem*> FinishedItems;
+
+	/* Baked curves, indexed through CurveIndices */
+	TArray<FCurveLUT> CurveLUTs;
+	TMap<FObjectKey, int32> CurveIndices;
+
+	/* Camera target and yaw of one character this frame */
+	struct FCharacterView
+	{
+		const AShooterCharacter* Character;
+		FVector InterpLocation;
+		double CameraYaw;
+	};
+
+	/* Scratch list of character views for UpdateInterps */
+	TArray<FCharacterView> CharacterViews;
+};
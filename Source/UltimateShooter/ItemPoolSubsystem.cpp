@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemPoolSubsystem.h"
+#include "UltimateShooter.h"
+#include "Item.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<int32> CVarItemPoolMaxFreePerClass(
+	TEXT("Shooter.ItemPool.MaxFreePerClass"),
+	32,
+	TEXT("Most parked items the item pool keeps per class. Items released past the limit are destroyed."));
+
+static FAutoConsoleCommandWithWorld ItemPoolStatsCommand(
+	TEXT("Shooter.ItemPool.Stats"),
+	TEXT("Log item pool occupancy and spawn counters for the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UItemPoolSubsystem* ItemPool = World ? World->GetSubsystem<UItemPoolSubsystem>() : nullptr)
+		{
+			ItemPool->DumpStats();
+		}
+	}));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item Pool Parked"), STAT_ItemPoolParked, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item Pool Spawned"), STAT_ItemPoolSpawned, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item Pool Hits"), STAT_ItemPoolHits, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item Pool Misses"), STAT_ItemPoolMisses, STATGROUP_UltimateShooter);
+
+UItemPoolSubsystem::UItemPoolSubsystem() :
+	NumSpawned(0),
+	PoolHits(0),
+	PoolMisses(0),
+	PoolOverflows(0)
+{
+}
+
+bool UItemPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UItemPoolSubsystem::Deinitialize()
+{
+	// The world tears the parked actors down with everything else
+	for (const auto& Bucket : Buckets)
+	{
+		DEC_DWORD_STAT_BY(STAT_ItemPoolParked, Bucket.Value.FreeItems.Num());
+	}
+	Buckets.Empty();
+
+	Super::Deinitialize();
+}
+
+AItem* UItemPoolSubsystem::SpawnItem(const UObject* WorldContextObject, TSubclassOf<AItem> ItemClass, const FTransform& Transform)
+{
+	if (ItemClass == nullptr || WorldContextObject == nullptr) return nullptr;
+
+	UWorld* World = WorldContextObject->GetWorld();
+	if (World == nullptr) return nullptr;
+
+	if (UItemPoolSubsystem* ItemPool = World->GetSubsystem<UItemPoolSubsystem>())
+	{
+		return ItemPool->AcquireItem(ItemClass, Transform);
+	}
+	return World->SpawnActor<AItem>(ItemClass, Transform);
+}
+
+void UItemPoolSubsystem::DespawnItem(AItem* Item)
+{
+	if (!IsValid(Item)) return;
+
+	if (UItemPoolSubsystem* ItemPool = Item->GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		ItemPool->ReleaseItem(Item);
+	}
+	else
+	{
+		Item->Destroy();
+	}
+}
+
+void UItemPoolSubsystem::Prewarm(TSubclassOf<AItem> ItemClass, int32 Count)
+{
+	if (ItemClass == nullptr) return;
+
+	FItemPoolBucket& Bucket = Buckets.FindOrAdd(ItemClass);
+	const int32 TargetCount = FMath::Min(Count, CVarItemPoolMaxFreePerClass.GetValueOnGameThread());
+	while (Bucket.FreeItems.Num() < TargetCount)
+	{
+		AItem* Item = SpawnParkedItem(ItemClass);
+		if (Item == nullptr) break;
+
+		Bucket.FreeItems.Add(Item);
+		INC_DWORD_STAT(STAT_ItemPoolParked);
+	}
+}
+
+AItem* UItemPoolSubsystem::AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform)
+{
+	if (ItemClass == nullptr) return nullptr;
+
+	AItem* Item = nullptr;
+
+	FItemPoolBucket* Bucket = Buckets.Find(ItemClass);
+	while (Bucket && Bucket->FreeItems.Num() > 0 && Item == nullptr)
+	{
+		// Parked items can still be destroyed from outside, e.g. by a level unloading
+		Item = Bucket->FreeItems.Pop(false);
+		DEC_DWORD_STAT(STAT_ItemPoolParked);
+		if (!IsValid(Item))
+		{
+			Item = nullptr;
+		}
+	}
+
+	if (Item)
+	{
+		++PoolHits;
+		INC_DWORD_STAT(STAT_ItemPoolHits);
+	}
+	else
+	{
+		Item = SpawnParkedItem(ItemClass);
+		if (Item == nullptr) return nullptr;
+
+		++PoolMisses;
+		INC_DWORD_STAT(STAT_ItemPoolMisses);
+	}
+
+	Item->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	Item->SetItemState(EItemState::EIS_Pickup);
+	return Item;
+}
+
+void UItemPoolSubsystem::ReleaseItem(AItem* Item)
+{
+	if (!IsValid(Item)) return;
+
+	FItemPoolBucket& Bucket = Buckets.FindOrAdd(Item->GetClass());
+	if (Bucket.FreeItems.Num() >= CVarItemPoolMaxFreePerClass.GetValueOnGameThread())
+	{
+		++PoolOverflows;
+		Item->Destroy();
+		return;
+	}
+
+	Item->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Item->ResetPooledItem();
+	Item->SetItemState(EItemState::EIS_Parked);
+
+	Bucket.FreeItems.Add(Item);
+	INC_DWORD_STAT(STAT_ItemPoolParked);
+}
+
+void UItemPoolSubsystem::DumpStats() const
+{
+	int32 NumParked = 0;
+	for (const auto& Bucket : Buckets)
+	{
+		NumParked += Bucket.Value.FreeItems.Num();
+	}
+
+	const int32 NumAcquires = PoolHits + PoolMisses;
+	UE_LOG(LogUltimateShooter, Log, TEXT("Item pool: %d spawned, %d parked (max %d per class), %d hits, %d misses (%.1f%% spawns avoided), %d overflows"),
+		NumSpawned,
+		NumParked,
+		CVarItemPoolMaxFreePerClass.GetValueOnGameThread(),
+		PoolHits,
+		PoolMisses,
+		NumAcquires > 0 ? 100.f * PoolHits / NumAcquires : 0.f,
+		PoolOverflows);
+
+	for (const auto& Bucket : Buckets)
+	{
+		UE_LOG(LogUltimateShooter, Log, TEXT("    %s: %d parked"), *GetNameSafe(Bucket.Key), Bucket.Value.FreeItems.Num());
+	}
+}
+
+AItem* UItemPoolSubsystem::SpawnParkedItem(UClass* ItemClass)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AItem* Item = GetWorld()->SpawnActor<AItem>(ItemClass, FTransform::Identity, SpawnParameters);
+	if (Item == nullptr) return nullptr;
+
+	Item->SetItemState(EItemState::EIS_Parked);
+
+	++NumSpawned;
+	INC_DWORD_STAT(STAT_ItemPoolSpawned);
+	return Item;
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemPoolSubsystem.generated.h"
+
+class AItem;
+
+/* Parked items ready to be handed out for one item class */
+USTRUCT()
+struct FItemPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AItem*> FreeItems;
+};
+
+/**
+ * Pools weapons and pickups per class so loot does not construct, register and garbage collect
+ * an actor every time one appears. Free items are parked in EIS_Parked, hidden and without collision
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UItemPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UItemPoolSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/* Acquire ItemClass through the world's pool, or spawn it if there is no pool */
+	template<typename ItemType>
+	static ItemType* SpawnItem(const UObject* WorldContextObject, TSubclassOf<ItemType> ItemClass, const FTransform& Transform)
+	{
+		return Cast<ItemType>(SpawnItem(WorldContextObject, TSubclassOf<AItem>(ItemClass), Transform));
+	}
+	static AItem* SpawnItem(const UObject* WorldContextObject, TSubclassOf<AItem> ItemClass, const FTransform& Transform);
+
+	/* Release Item to the world's pool, or destroy it if there is no pool */
+	static void DespawnItem(AItem* Item);
+
+	/* Spawn parked items of ItemClass until it has at least Count of them */
+	void Prewarm(TSubclassOf<AItem> ItemClass, int32 Count);
+
+	/* Hand out a parked item of ItemClass, or spawn one, as a pickup at Transform */
+	AItem* AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform);
+
+	/* Park Item until it is acquired again. Destroys it if its class already has enough parked items */
+	void ReleaseItem(AItem* Item);
+
+	/* Log pool occupancy and spawn counters */
+	void DumpStats() const;
+
+private:
+	/* Spawn a new item and park it */
+	AItem* SpawnParkedItem(UClass* ItemClass);
+
+	/* Parked items per class */
+	UPROPERTY()
+	TMap<UClass*, FItemPoolBucket> Buckets;
+
+	/* Items spawned by the pool */
+	int32 NumSpawned;
+
+	/* Acquires served from a parked item */
+	int32 PoolHits;
+
+	/* Acquires that had to spawn */
+	int32 PoolMisses;
+
+	/* Releases that destroyed the item because its bucket was full */
+	int32 PoolOverflows;
+
+public:
+	FORCEINLINE int32 GetNumSpawned() const { return NumSpawned; }
+	FORCEINLINE int32 GetPoolHits() const { return PoolHits; }
+	FORCEINLINE int32 GetPoolMisses() const { return PoolMisses; }
+	FORCEINLINE int32 GetPoolOverflows() const { return PoolOverflows; }
+};
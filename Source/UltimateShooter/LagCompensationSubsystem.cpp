@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LagCompensationSubsystem.h"
+#include "UltimateShooter.h"
+#include "ShooterCharacter.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarLagCompensationEnable(
+	TEXT("Shooter.LagCompensation.Enable"),
+	true,
+	TEXT("Rewind characters to the shooter's time when the server validates hitscan shots from remote players."));
+
+static TAutoConsoleVariable<int32> CVarLagCompensationHistoryLength(
+	TEXT("Shooter.LagCompensation.HistoryLength"),
+	64,
+	TEXT("Number of server ticks of hitbox history kept per character. Read when a world starts."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarLagCompensationMaxRewindTime(
+	TEXT("Shooter.LagCompensation.MaxRewindTime"),
+	0.5f,
+	TEXT("Furthest back in seconds a client's shot time may rewind characters, older claims are clamped."));
+
+DECLARE_CYCLE_STAT(TEXT("LagCompensation Record"), STAT_LagCompensationRecord, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("LagCompensation Rewind"), STAT_LagCompensationRewind, STATGROUP_UltimateShooter);
+
+FLagCompensationHistory::FLagCompensationHistory(int32 InHistoryLength) :
+	HistoryLength(FMath::Max(InHistoryLength, 2)),
+	TrackCapacity(0),
+	NumTracks(0),
+	NewestSample(0),
+	NumSamples(0)
+{
+	SampleTimes.SetNumZeroed(HistoryLength);
+}
+
+int32 FLagCompensationHistory::AddTrack(const FVector3f& Location, const FQuat4f& Rotation)
+{
+	if (NumTracks == TrackCapacity)
+	{
+		SetTrackCapacity(FMath::Max(8, TrackCapacity * 2));
+	}
+
+	// Rewinding to before the track existed gives its first transform
+	const int32 TrackIndex = NumTracks++;
+	for (int32 Sample = 0; Sample < HistoryLength; ++Sample)
+	{
+		Locations[Sample * TrackCapacity + TrackIndex] = Location;
+		Rotations[Sample * TrackCapacity + TrackIndex] = Rotation;
+	}
+	return TrackIndex;
+}
+
+void FLagCompensationHistory::RemoveTrackAtSwap(int32 TrackIndex)
+{
+	check(TrackIndex >= 0 && TrackIndex < NumTracks);
+
+	const int32 LastTrack = --NumTracks;
+	if (TrackIndex != LastTrack)
+	{
+		for (int32 Sample = 0; Sample < HistoryLength; ++Sample)
+		{
+			const int32 RowStart = Sample * TrackCapacity;
+			Locations[RowStart + TrackIndex] = Locations[RowStart + LastTrack];
+			Rotations[RowStart + TrackIndex] = Rotations[RowStart + LastTrack];
+		}
+	}
+}
+
+void FLagCompensationHistory::Record(double Time, TArrayView<const FVector3f> TrackLocations, TArrayView<const FQuat4f> TrackRotations)
+{
+	check(TrackLocations.Num() == NumTracks && TrackRotations.Num() == NumTracks);
+
+	NewestSample = (NewestSample + 1) % HistoryLength;
+	NumSamples = FMath::Min(NumSamples + 1, HistoryLength);
+	SampleTimes[NewestSample] = Time;
+
+	const int32 RowStart = NewestSample * TrackCapacity;
+	FMemory::Memcpy(&Locations[RowStart], TrackLocations.GetData(), NumTracks * sizeof(FVector3f));
+	FMemory::Memcpy(&Rotations[RowStart], TrackRotations.GetData(), NumTracks * sizeof(FQuat4f));
+}
+
+bool FLagCompensationHistory::Rewind(double Time, TArrayView<FVector3f> OutLocations, TArrayView<FQuat4f> OutRotations) const
+{
+	check(OutLocations.Num() >= NumTracks && OutRotations.Num() >= NumTracks);
+	if (NumSamples == 0 || NumTracks == 0) return false;
+
+	// Shots are usually fired a few ticks ago, so walk back from the newest row
+	int32 NewerSample = GetSampleIndex(0);
+	int32 OlderSample = NewerSample;
+	for (int32 Age = 1; Age < NumSamples && SampleTimes[OlderSample] > Time; ++Age)
+	{
+		NewerSample = OlderSample;
+		OlderSample = GetSampleIndex(Age);
+	}
+
+	const double OlderTime = SampleTimes[OlderSample];
+	const double NewerTime = SampleTimes[NewerSample];
+	const float Alpha = NewerTime > OlderTime ?
+		static_cast<float>(FMath::Clamp((Time - OlderTime) / (NewerTime - OlderTime), 0.0, 1.0)) :
+		0.f;
+
+	const FVector3f* OlderLocations = &Locations[OlderSample * TrackCapacity];
+	const FVector3f* NewerLocations = &Locations[NewerSample * TrackCapacity];
+	const FQuat4f* OlderRotations = &Rotations[OlderSample * TrackCapacity];
+	const FQuat4f* NewerRotations = &Rotations[NewerSample * TrackCapacity];
+	for (int32 Track = 0; Track < NumTracks; ++Track)
+	{
+		OutLocations[Track] = FMath::Lerp(OlderLocations[Track], NewerLocations[Track], Alpha);
+		OutRotations[Track] = FQuat4f::FastLerp(OlderRotations[Track], NewerRotations[Track], Alpha).GetNormalized();
+	}
+	return true;
+}
+
+void FLagCompensationHistory::SetTrackCapacity(int32 NewTrackCapacity)
+{
+	TArray<FVector3f> NewLocations;
+	TArray<FQuat4f> NewRotations;
+	NewLocations.SetNumUninitialized(HistoryLength * NewTrackCapacity);
+	NewRotations.SetNumUninitialized(HistoryLength * NewTrackCapacity);
+
+	// Re-stride every row to the new capacity
+	for (int32 Sample = 0; Sample < HistoryLength && NumTracks > 0; ++Sample)
+	{
+		FMemory::Memcpy(&NewLocations[Sample * NewTrackCapacity], &Locations[Sample * TrackCapacity], NumTracks * sizeof(FVector3f));
+		FMemory::Memcpy(&NewRotations[Sample * NewTrackCapacity], &Rotations[Sample * TrackCapacity], NumTracks * sizeof(FQuat4f));
+	}
+
+	Locations = MoveTemp(NewLocations);
+	Rotations = MoveTemp(NewRotations);
+	TrackCapacity = NewTrackCapacity;
+}
+
+ULagCompensationSubsystem::ULagCompensationSubsystem()
+{
+}
+
+bool ULagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	History = FLagCompensationHistory(CVarLagCompensationHistoryLength.GetValueOnGameThread());
+	UE_LOG(LogUltimateShooter, Verbose, TEXT("Lag compensation: %d samples, %llu bytes per character"),
+		History.GetHistoryLength(),
+		static_cast<uint64>(History.GetBytesPerTrack()));
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only the server validates shots
+	if (GetWorld()->GetNetMode() == NM_Client || Characters.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	TrackLocations.SetNumUninitialized(Characters.Num(), false);
+	TrackRotations.SetNumUninitialized(Characters.Num(), false);
+	for (int32 Track = 0; Track < Characters.Num(); ++Track)
+	{
+		const FTransform& CharacterTransform = Characters[Track]->GetActorTransform();
+		TrackLocations[Track] = FVector3f(CharacterTransform.GetLocation());
+		TrackRotations[Track] = FQuat4f(CharacterTransform.GetRotation());
+	}
+	History.Record(GetWorld()->GetTimeSeconds(), TrackLocations, TrackRotations);
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(AShooterCharacter* Character)
+{
+	if (Character == nullptr || Characters.Contains(Character)) return;
+
+	const FTransform& CharacterTransform = Character->GetActorTransform();
+	History.AddTrack(FVector3f(CharacterTransform.GetLocation()), FQuat4f(CharacterTransform.GetRotation()));
+	Characters.Add(Character);
+}
+
+void ULagCompensationSubsystem::UnregisterCharacter(AShooterCharacter* Character)
+{
+	const int32 Track = Characters.Find(Character);
+	if (Track == INDEX_NONE) return;
+
+	// Both swap the last entry into Track, so indices keep matching
+	History.RemoveTrackAtSwap(Track);
+	Characters.RemoveAtSwap(Track);
+}
+
+bool ULagCompensationSubsystem::LineTraceRewound(double ShotTime, const AShooterCharacter* Shooter, FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel)
+{
+	return LineTracesRewound(ShotTime, Shooter, MakeArrayView(&OutHit, 1), Start, MakeArrayView(&End, 1), TraceChannel) > 0;
+}
+
+int32 ULagCompensationSubsystem::LineTracesRewound(double ShotTime, const AShooterCharacter* Shooter, TArrayView<FHitResult> OutHits, const FVector& Start, TArrayView<const FVector> Ends, ECollisionChannel TraceChannel)
+{
+	check(OutHits.Num() == Ends.Num());
+
+	UWorld* World = GetWorld();
+	auto TraceAll = [&]()
+	{
+		int32 NumHits = 0;
+		for (int32 Index = 0; Index < Ends.Num(); ++Index)
+		{
+			NumHits += World->LineTraceSingleByChannel(OutHits[Index], Start, Ends[Index], TraceChannel) ? 1 : 0;
+		}
+		return NumHits;
+	};
+
+	// Shot times come from clients, don't let them reach further back than any sane ping
+	const double Now = World->GetTimeSeconds();
+	ShotTime = FMath::Clamp(ShotTime, Now - CVarLagCompensationMaxRewindTime.GetValueOnGameThread(), Now);
+
+	TrackLocations.SetNumUninitialized(Characters.Num(), false);
+	TrackRotations.SetNumUninitialized(Characters.Num(), false);
+	if (!CVarLagCompensationEnable.GetValueOnGameThread() || !History.Rewind(ShotTime, TrackLocations, TrackRotations))
+	{
+		return TraceAll();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRewind);
+
+	// Move everyone else back to where the shooter saw them
+	TArray<FTransform, TInlineAllocator<16>> RestoreTransforms;
+	TArray<AShooterCharacter*, TInlineAllocator<16>> RewoundCharacters;
+	for (int32 Track = 0; Track < Characters.Num(); ++Track)
+	{
+		AShooterCharacter* Character = Characters[Track];
+		if (Character == Shooter) continue;
+
+		const FVector RewoundLocation{ TrackLocations[Track] };
+		const FQuat RewoundRotation{ TrackRotations[Track] };
+		const FTransform& CurrentTransform = Character->GetActorTransform();
+		if (RewoundLocation.Equals(CurrentTransform.GetLocation()) && RewoundRotation.Equals(CurrentTransform.GetRotation())) continue;
+
+		RestoreTransforms.Add(CurrentTransform);
+		RewoundCharacters.Add(Character);
+		Character->SetActorLocationAndRotation(RewoundLocation, RewoundRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	// Every trace shares the one rewind
+	const int32 NumHits = TraceAll();
+
+	// Put everyone back
+	for (int32 Index = 0; Index < RewoundCharacters.Num(); ++Index)
+	{
+		RewoundCharacters[Index]->SetActorLocationAndRotation(
+			RestoreTransforms[Index].GetLocation(),
+			RestoreTransforms[Index].GetRotation(),
+			false,
+			nullptr,
+			ETeleportType::TeleportPhysics);
+	}
+
+	return NumHits;
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand LagCompensationBenchmarkCommand(
+	TEXT("Shooter.Bench.LagCompensation"),
+	TEXT("Measure the cost of rewinding the hitbox history for 8 to 256 characters.\n")
+	TEXT("Usage: Shooter.Bench.LagCompensation [Rewinds=10000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumRewinds = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10'000;
+		const int32 HistoryLength = CVarLagCompensationHistoryLength.GetValueOnGameThread();
+		const double TickInterval = 1.0 / 30.0;
+
+		FRandomStream Random(1337);
+		const int32 PlayerCounts[] = { 8, 16, 32, 64, 128, 256 };
+		for (const int32 NumPlayers : PlayerCounts)
+		{
+			FLagCompensationHistory History(HistoryLength);
+			for (int32 Player = 0; Player < NumPlayers; ++Player)
+			{
+				History.AddTrack(FVector3f::ZeroVector, FQuat4f::Identity);
+			}
+
+			// Fill the whole ring with random movement
+			TArray<FVector3f> Locations;
+			TArray<FQuat4f> Rotations;
+			Locations.SetNumUninitialized(NumPlayers);
+			Rotations.SetNumUninitialized(NumPlayers);
+			for (int32 Sample = 0; Sample < HistoryLength; ++Sample)
+			{
+				for (int32 Player = 0; Player < NumPlayers; ++Player)
+				{
+					Locations[Player] = FVector3f(Random.VRand() * 5'000.f);
+					Rotations[Player] = FQuat4f(FRotator3f(0.f, Random.FRandRange(-180.f, 180.f), 0.f));
+				}
+				History.Record(Sample * TickInterval, Locations, Rotations);
+			}
+
+			// Rewind to random times inside the recorded window, like pings would
+			const double WindowEnd = (HistoryLength - 1) * TickInterval;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Rewind = 0; Rewind < NumRewinds; ++Rewind)
+			{
+				History.Rewind(WindowEnd - Random.FRand() * WindowEnd, Locations, Rotations);
+			}
+			const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+			UE_LOG(LogUltimateShooter, Log, TEXT("Lag compensation rewind: %3d players, %7.3f us per rewind, %5.1f KB history"),
+				NumPlayers,
+				ElapsedSeconds * 1'000'000.0 / NumRewinds,
+				History.GetBytesPerTrack() * NumPlayers / 1024.f);
+		}
+	}));
+
+#endif
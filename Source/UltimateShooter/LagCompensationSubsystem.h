@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class AShooterCharacter;
+
+/**
+ * Fixed size ring buffer of hitbox transforms for a number of tracks, one track per character.
+ * Stored as structure of arrays where every recorded sample is one row holding all tracks,
+ * so rewinding everyone to a point in time reads two contiguous rows.
+ */
+class ULTIMATESHOOTER_API FLagCompensationHistory
+{
+public:
+	explicit FLagCompensationHistory(int32 InHistoryLength = 64);
+
+	/* Add a track whose whole history starts out at Location/Rotation, returns its index */
+	int32 AddTrack(const FVector3f& Location, const FQuat4f& Rotation);
+
+	/* Remove a track, the last track takes its index */
+	void RemoveTrackAtSwap(int32 TrackIndex);
+
+	/* Record a new row with one transform per track, overwriting the oldest row when full */
+	void Record(double Time, TArrayView<const FVector3f> TrackLocations, TArrayView<const FQuat4f> TrackRotations);
+
+	/**
+	* Interpolate every track to Time. Times outside the recorded window clamp to the oldest/newest row
+	* @return False if nothing has been recorded yet
+	*/
+	bool Rewind(double Time, TArrayView<FVector3f> OutLocations, TArrayView<FQuat4f> OutRotations) const;
+
+	FORCEINLINE int32 GetNumTracks() const { return NumTracks; }
+	FORCEINLINE int32 GetHistoryLength() const { return HistoryLength; }
+
+	/* Memory one track costs across the whole history */
+	FORCEINLINE SIZE_T GetBytesPerTrack() const { return HistoryLength * (sizeof(FVector3f) + sizeof(FQuat4f)); }
+
+private:
+	/* Grow room for tracks in every row */
+	void SetTrackCapacity(int32 NewTrackCapacity);
+
+	/* Ring index of the row Age samples older than the newest */
+	FORCEINLINE int32 GetSampleIndex(int32 Age) const { return (NewestSample - Age + HistoryLength) % HistoryLength; }
+
+	/* Number of rows in the ring */
+	int32 HistoryLength;
+
+	/* Tracks each row has room for */
+	int32 TrackCapacity;
+
+	int32 NumTracks;
+
+	/* Ring index of the newest row */
+	int32 NewestSample;
+
+	/* Rows recorded so far, up to HistoryLength */
+	int32 NumSamples;
+
+	/* Time each row was recorded at */
+	TArray<double> SampleTimes;
+
+	/* Row major, [Sample * TrackCapacity + Track] */
+	TArray<FVector3f> Locations;
+	TArray<FQuat4f> Rotations;
+};
+
+/**
+ * Server side lag compensation. Records every AShooterCharacter's hitbox each tick and rewinds
+ * them to the time a shot was fired on the shooter's screen to validate it
+ */
+UCLASS()
+class ULTIMATESHOOTER_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	ULagCompensationSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Start recording Character's hitbox */
+	void RegisterCharacter(AShooterCharacter* Character);
+
+	/* Stop recording Character's hitbox */
+	void UnregisterCharacter(AShooterCharacter* Character);
+
+	/**
+	* Line trace with every character except Shooter rewound to ShotTime, restored afterwards
+	* @param ShotTime  Server world time the shooter saw when firing, clamped to Shooter.LagCompensation.MaxRewindTime
+	* @return True on a blocking hit
+	*/
+	bool LineTraceRewound(double ShotTime, const AShooterCharacter* Shooter, FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel);
+
+	/**
+	* Line traces from Start to each of Ends under a single rewind, for shots firing several pellets
+	* @return Number of traces with a blocking hit
+	*/
+	int32 LineTracesRewound(double ShotTime, const AShooterCharacter* Shooter, TArrayView<FHitResult> OutHits, const FVector& Start, TArrayView<const FVector> Ends, ECollisionChannel TraceChannel);
+
+private:
+	/* Hitbox history, track index matches the index into Characters */
+	FLagCompensationHistory History;
+
+	/* Registered characters */
+	UPROPERTY()
+	TArray<AShooterCharacter*> Characters;
+
+	/* Scratch rows reused for recording and rewinding */
+	TArray<FVector3f> TrackLocations;
+	TArray<FQuat4f> TrackRotations;
+};
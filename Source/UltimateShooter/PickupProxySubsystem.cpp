@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupProxySubsystem.h"
+#include "UltimateShooter.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+static TAutoConsoleVariable<bool> CVarPickupProxyEnabled(
+	TEXT("Shooter.PickupProxy.Enabled"),
+	true,
+	TEXT("Draw items lying in the pickup state as instanced static meshes.\n")
+	TEXT("False keeps their skeletal mesh. Takes effect on the next item state change."));
+
+static FAutoConsoleCommandWithWorld PickupProxyStatsCommand(
+	TEXT("Shooter.PickupProxy.Stats"),
+	TEXT("Log pickup proxy counts per mesh for the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UPickupProxySubsystem* PickupProxies = World ? World->GetSubsystem<UPickupProxySubsystem>() : nullptr)
+		{
+			PickupProxies->DumpStats();
+		}
+	}));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pickup Proxies"), STAT_PickupProxies, STATGROUP_UltimateShooter);
+
+bool UPickupProxySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UPickupProxySubsystem::Deinitialize()
+{
+	for (auto& Batch : Batches)
+	{
+		if (IsValid(Batch.Value.Component))
+		{
+			Batch.Value.Component->DestroyComponent();
+		}
+	}
+	Batches.Empty();
+
+	DEC_DWORD_STAT_BY(STAT_PickupProxies, ItemInstances.Num());
+	ItemInstances.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UPickupProxySubsystem::CanProxyItem(const AItem* Item, EItemState State) const
+{
+	return Item
+		&& State == EItemState::EIS_Pickup
+		&& Item->GetDefinition()->GetPickupMesh() != nullptr
+		&& CVarPickupProxyEnabled.GetValueOnGameThread();
+}
+
+bool UPickupProxySubsystem::UpdateItem(AItem* Item)
+{
+	if (!CanProxyItem(Item, Item ? Item->GetItemState() : EItemState::EIS_MAX))
+	{
+		RemoveItem(Item);
+		return false;
+	}
+
+	UStaticMesh* Mesh = Item->GetDefinition()->GetPickupMesh();
+	const FTransform Transform{ Item->GetItemMesh()->GetComponentTransform() };
+
+	if (const TPair<UStaticMesh*, int32>* Instance = ItemInstances.Find(Item))
+	{
+		if (Instance->Key == Mesh)
+		{
+			Batches[Mesh].Component->UpdateInstanceTransform(Instance->Value, Transform, true, true);
+			return true;
+		}
+		// Definition changed, move to the batch of the new mesh
+		RemoveItem(Item);
+	}
+
+	FPickupProxyBatch& Batch = FindOrAddBatch(Mesh);
+	const int32 InstanceIndex = Batch.Component->AddInstance(Transform, true);
+	check(InstanceIndex == Batch.Items.Num());
+	Batch.Items.Add(Item);
+	ItemInstances.Add(Item, TPair<UStaticMesh*, int32>(Mesh, InstanceIndex));
+	INC_DWORD_STAT(STAT_PickupProxies);
+
+	return true;
+}
+
+void UPickupProxySubsystem::RemoveItem(AItem* Item)
+{
+	TPair<UStaticMesh*, int32> Instance;
+	if (!ItemInstances.RemoveAndCopyValue(Item, Instance)) return;
+	DEC_DWORD_STAT(STAT_PickupProxies);
+
+	FPickupProxyBatch& Batch = Batches[Instance.Key];
+	const int32 InstanceIndex = Instance.Value;
+	const int32 LastIndex = Batch.Items.Num() - 1;
+
+	// Removing anything but the last instance shifts every instance after it, move the last one into the gap instead
+	if (InstanceIndex != LastIndex)
+	{
+		FTransform LastTransform;
+		Batch.Component->GetInstanceTransform(LastIndex, LastTransform, true);
+		Batch.Component->UpdateInstanceTransform(InstanceIndex, LastTransform, true, false);
+
+		AItem* MovedItem = Batch.Items[LastIndex];
+		Batch.Items[InstanceIndex] = MovedItem;
+		ItemInstances[MovedItem].Value = InstanceIndex;
+	}
+	Batch.Component->RemoveInstance(LastIndex);
+	Batch.Items.Pop(false);
+}
+
+void UPickupProxySubsystem::DumpStats() const
+{
+	UE_LOG(LogUltimateShooter, Log, TEXT("Pickup proxies: %d items in %d batches (%s)"),
+		ItemInstances.Num(),
+		Batches.Num(),
+		CVarPickupProxyEnabled.GetValueOnGameThread() ? TEXT("enabled") : TEXT("disabled"));
+
+	for (const auto& Batch : Batches)
+	{
+		UE_LOG(LogUltimateShooter, Log, TEXT("    %s: %d instances"), *GetNameSafe(Batch.Key), Batch.Value.Items.Num());
+	}
+}
+
+FPickupProxyBatch& UPickupProxySubsystem::FindOrAddBatch(UStaticMesh* Mesh)
+{
+	FPickupProxyBatch& Batch = Batches.FindOrAdd(Mesh);
+	if (Batch.Component == nullptr)
+	{
+		UWorld* World = GetWorld();
+
+		// Owned by the world settings like other components that don't belong to any one actor
+		UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(World->GetWorldSettings(), NAME_None, RF_Transient);
+		Component->SetMobility(EComponentMobility::Movable);
+		Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Component->SetCanEverAffectNavigation(false);
+		Component->SetStaticMesh(Mesh);
+		Component->RegisterComponentWithWorld(World);
+
+		Batch.Component = Component;
+	}
+	return Batch;
+}
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Item.h"
+#include "PickupProxySubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/* Instances drawing every proxied pickup that uses one static mesh */
+USTRUCT()
+struct FPickupProxyBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* Component = nullptr;
+
+	/* Item drawn by each instance, in instance order */
+	UPROPERTY()
+	TArray<AItem*> Items;
+};
+
+/**
+ * Draws items lying in the pickup state as instances of their definition's static pickup mesh.
+ * Their skeletal mesh is hidden and stops updating bones until the item is picked up or dropped,
+ * so a loot field costs one instanced draw per kind of item instead of a skinned mesh per item
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UPickupProxySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/* True if Item would be drawn by a proxy in State */
+	bool CanProxyItem(const AItem* Item, EItemState State) const;
+
+	/**
+	* Add or move Item's proxy instance if it can be proxied in its current state, remove it otherwise
+	* @return True if the item is drawn by a proxy
+	*/
+	bool UpdateItem(AItem* Item);
+
+	/* Remove Item's proxy instance */
+	void RemoveItem(AItem* Item);
+
+	FORCEINLINE int32 GetNumProxies() const { return ItemInstances.Num(); }
+
+	/* Log proxy counts per mesh */
+	void DumpStats() const;
+
+private:
+	/* Batch for Mesh, creating its component on first use */
+	FPickupProxyBatch& FindOrAddBatch(UStaticMesh* Mesh);
+
+	/* Batches per pickup mesh */
+	UPROPERTY()
+	TMap<UStaticMesh*, FPickupProxyBatch> Batches;
+
+	/* Mesh and instance index of every proxied item */
+	TMap<const AItem*, TPair<UStaticMesh*, int32>> ItemInstances;
+};
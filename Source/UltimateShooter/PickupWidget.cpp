@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupWidget.h"
+#include "Item.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/TextBlock.h"
+#include "Components/VerticalBox.h"
+
+void UPickupWidget::SetItem(AItem* InItem)
+{
+	if (IsValid(Item))
+	{
+		Item->OnItemCountChanged().Remove(ItemCountChangedHandle);
+	}
+	ItemCountChangedHandle.Reset();
+
+	Item = InItem;
+	if (Item)
+	{
+		ItemName = Item->GetItemName();
+		ItemCount = Item->GetItemCount();
+		Item->GetDefinition()->GetActiveStars(ActiveStars);
+		ItemCountChangedHandle = Item->OnItemCountChanged().AddUObject(this, &UPickupWidget::HandleItemCountChanged);
+	}
+	RefreshDefaultLayout();
+	OnItemChanged();
+}
+
+TSharedRef<SWidget> UPickupWidget::RebuildWidget()
+{
+	// A Blueprint layout shows the properties itself
+	if (WidgetTree == nullptr || WidgetTree->RootWidget) return Super::RebuildWidget();
+
+	UVerticalBox* Box = WidgetTree->ConstructWidget<UVerticalBox>(UVerticalBox::StaticClass(), TEXT("DefaultLayout"));
+	WidgetTree->RootWidget = Box;
+
+	auto AddText = [this, Box](FName Name)
+	{
+		UTextBlock* Text = WidgetTree->ConstructWidget<UTextBlock>(UTextBlock::StaticClass(), Name);
+		Text->SetShadowOffset(FVector2D(1.f, 1.f));
+		Text->SetShadowColorAndOpacity(FLinearColor(0.f, 0.f, 0.f, 0.8f));
+		Box->AddChildToVerticalBox(Text);
+		return Text;
+	};
+	DefaultNameText = AddText(TEXT("ItemNameText"));
+	DefaultCountText = AddText(TEXT("ItemCountText"));
+	DefaultStarsText = AddText(TEXT("ItemStarsText"));
+	RefreshDefaultLayout();
+
+	return Super::RebuildWidget();
+}
+
+void UPickupWidget::NativeDestruct()
+{
+	if (IsValid(Item))
+	{
+		Item->OnItemCountChanged().Remove(ItemCountChangedHandle);
+	}
+	ItemCountChangedHandle.Reset();
+
+	Super::NativeDestruct();
+}
+
+void UPickupWidget::HandleItemCountChanged(AItem* ChangedItem)
+{
+	ItemCount = ChangedItem->GetItemCount();
+	RefreshDefaultLayout();
+	OnItemChanged();
+}
+
+void UPickupWidget::RefreshDefaultLayout()
+{
+	if (DefaultNameText == nullptr) return;
+
+	DefaultNameText->SetText(FText::FromString(ItemName));
+	DefaultCountText->SetText(FText::AsNumber(ItemCount));
+
+	// Index 0 isn't a star, see UItemDefinition::GetActiveStars
+	FString Stars;
+	for (int32 i = 1; i < ActiveStars.Num(); i++)
+	{
+		if (ActiveStars[i]) Stars.AppendChar(TEXT('*'));
+	}
+	DefaultStarsText->SetText(FText::FromString(Stars));
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "PickupWidget.generated.h"
+
+class AItem;
+class UTextBlock;
+
+/**
+ * Popup shown over the item the player is looking at. One instance is shared by every item,
+ * the character fills it with the focused item's properties when the focus changes.
+ * Used as is, without a Blueprint layout, it builds a plain text layout of its own
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UPickupWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	/* Copy Item's name, count and rarity stars into the widget */
+	void SetItem(AItem* InItem);
+
+	FORCEINLINE AItem* GetItem() const { return Item; }
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+	virtual void NativeDestruct() override;
+
+	/* Called after SetItem, the properties below already describe the new item */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pickup Widget")
+	void OnItemChanged();
+
+private:
+	/* Keep ItemCount up to date while the item is shown, e.g. an ammo box absorbing another */
+	void HandleItemCountChanged(AItem* ChangedItem);
+
+	/* Show the properties in the default layout, does nothing for Blueprints that have their own */
+	void RefreshDefaultLayout();
+
+	/* Item the widget is showing */
+	UPROPERTY(BlueprintReadOnly, Category = "Pickup Widget", meta = (AllowPrivateAccess = "true"))
+	AItem* Item;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Pickup Widget", meta = (AllowPrivateAccess = "true"))
+	FString ItemName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Pickup Widget", meta = (AllowPrivateAccess = "true"))
+	int32 ItemCount;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Pickup Widget", meta = (AllowPrivateAccess = "true"))
+	TArray<bool> ActiveStars;
+
+	FDelegateHandle ItemCountChangedHandle;
+
+	/* Text of the layout RebuildWidget builds when no Blueprint layout exists */
+	UPROPERTY(Transient)
+	UTextBlock* DefaultNameText;
+
+	UPROPERTY(Transient)
+	UTextBlock* DefaultCountText;
+
+	UPROPERTY(Transient)
+	UTextBlock* DefaultStarsText;
+};
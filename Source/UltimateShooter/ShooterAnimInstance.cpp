@@ -3,9 +3,17 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "ShooterAnimInstance.h"
 #include "ShooterCharacter.h"
+#include "UltimateShooter.h"
+#include "ShooterDiagnosticsSubsystem.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shooter Anim Gather Snapshot"), STAT_ShooterAnimGatherSnapshot, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("Shooter Anim Thread Safe Update"), STAT_ShooterAnimThreadSafeUpdate, STATGROUP_UltimateShooter);
 
 UShooterAnimInstance::UShooterAnimInstance():
+	bUpdatedFromEventGraph(false),
 	Speed(0.f),
 	bIsInAir(false),
 	bIsAccelerating(false),
@@ -27,34 +35,93 @@ UShooterAnimInstance::UShooterAnimInstance():
 
 void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
 {
+	// Called from the event graph, which runs after NativeUpdateAnimation filled the snapshot. Nodes after the call
+	// read the properties, so they have to be up to date now rather than after the thread safe update
+	static bool bWarned = false;
+	if (!bWarned)
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("%s still calls UpdateAnimationProperties, remove the call to update on worker threads"), *GetClass()->GetName());
+		bWarned = true;
+	}
+
+	UpdateFromSnapshot(DeltaTime);
+	bUpdatedFromEventGraph = true;
+}
+
+void UShooterAnimInstance::NativeInitializeAnimation()
+{
+	ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
+}
+
+void UShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterAnimGatherSnapshot);
+
 	if (ShooterCharacter == nullptr) 
 	{
 		ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
 	}
+
+	Snapshot.bValid = ShooterCharacter != nullptr;
 	if (ShooterCharacter)
 	{
-		bCrouching = ShooterCharacter->GetCrounching();
-		bReloading = ShooterCharacter->GetCombatState() == ECombatState::ECS_Reloading;
+		const UCharacterMovementComponent* CharacterMovement = ShooterCharacter->GetCharacterMovement();
+
+		Snapshot.Velocity = ShooterCharacter->GetVelocity();
+		Snapshot.ActorRotation = ShooterCharacter->GetActorRotation();
+		Snapshot.BaseAimRotation = ShooterCharacter->GetBaseAimRotation();
+		Snapshot.bIsFalling = CharacterMovement->IsFalling();
+		Snapshot.bIsAccelerating = CharacterMovement->GetCurrentAcceleration().SizeSquared() > 0.f;
+		Snapshot.bAiming = ShooterCharacter->GetIsAiming();
+		Snapshot.bCrouching = ShooterCharacter->GetCrounching();
+		Snapshot.bReloading = ShooterCharacter->GetCombatState() == ECombatState::ECS_Reloading;
+	}
+
+#if WITH_SHOOTER_DIAGNOSTICS
+	// Screen messages aren't safe off the game thread, show what the last thread safe update came up with
+	if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::TurnInPlace) && Snapshot.bValid && Speed == 0.f && !bIsInAir)
+	{
+		UShooterDiagnosticsSubsystem::AddMessage(EShooterDebugCategory::TurnInPlace, FString::Printf(TEXT("RootYawOffset: %f"), RootYawOffset));
+	}
+#endif
+}
+
+void UShooterAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	// Once per snapshot, the event graph may have done it already
+	if (bUpdatedFromEventGraph)
+	{
+		bUpdatedFromEventGraph = false;
+		return;
+	}
+
+	UpdateFromSnapshot(DeltaSeconds);
+}
+
+void UShooterAnimInstance::UpdateFromSnapshot(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterAnimThreadSafeUpdate);
+
+	if (Snapshot.bValid)
+	{
+		bCrouching = Snapshot.bCrouching;
+		bReloading = Snapshot.bReloading;
 
 		// Get the lateral speed if the character from velocity
-		FVector Velocity{ ShooterCharacter->GetVelocity() };
-		Velocity.Z = 0;
-		Speed = Velocity.Size();
+		Speed = Snapshot.Velocity.Size2D();
 
 		// Is the character in the air?
-		bIsInAir = ShooterCharacter->GetCharacterMovement()->IsFalling();
+		bIsInAir = Snapshot.bIsFalling;
 
 		// Is the character accelerating?
-		if (ShooterCharacter->GetCharacterMovement()->GetCurrentAcceleration().Size() > 0)
-		{
-			bIsAccelerating = true;
-		}
-		else {
-			bIsAccelerating = false;
-		}
+		bIsAccelerating = Snapshot.bIsAccelerating;
 
-		FRotator AimRotation = ShooterCharacter->GetBaseAimRotation();
-		FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(ShooterCharacter->GetVelocity());
+		const FRotator AimRotation = Snapshot.BaseAimRotation;
+		const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Snapshot.Velocity);
 		MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation).Yaw;
 
 		if (Speed > 0.f)
@@ -62,7 +129,7 @@ void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
 			LastMovementOffsetYaw = MovementOffsetYaw;
 		}
 
-		bAiming = ShooterCharacter->GetIsAiming();
+		bAiming = Snapshot.bAiming;
 
 		if (bReloading)
 		{
@@ -83,24 +150,19 @@ void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
 	}
 
 	TurnInPlace();
-	Lean(DeltaTime);
-}
-
-void UShooterAnimInstance::NativeInitializeAnimation()
-{
-	ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
+	Lean(DeltaSeconds);
 }
 
 void UShooterAnimInstance::TurnInPlace()
 {
-	if (ShooterCharacter == nullptr) return;
+	if (!Snapshot.bValid) return;
 
-	Pitch = ShooterCharacter->GetBaseAimRotation().Pitch;
+	Pitch = Snapshot.BaseAimRotation.Pitch;
 
 	if (Speed > 0 || bIsInAir)
 	{
 		RootYawOffset = 0.f;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
 		RotationCurve = 0.f;
 		RotationCurveLastFrame = 0.f;
@@ -108,7 +170,7 @@ void UShooterAnimInstance::TurnInPlace()
 	else
 	{
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 
 		const float TIPYawDelta{ TIPCharacterYaw - TIPCharacterYawLastFrame };
 
@@ -135,15 +197,14 @@ void UShooterAnimInstance::TurnInPlace()
 				RootYawOffset > 0 ? RootYawOffset -= YawExcess : RootYawOffset += YawExcess;
 			}
 		}
-		GEngine->AddOnScreenDebugMessage(1, -1, FColor::Green, FString::Printf(TEXT("RootYawOffset: %f"), RootYawOffset));
 	}
 }
 
 void UShooterAnimInstance::Lean(float DeltaTime)
 {
-	if (ShooterCharacter == nullptr) return;
+	if (!Snapshot.bValid) return;
 	CharacterRotationLastFrame = CharacterRotation;
-	CharacterRotation = ShooterCharacter->GetActorRotation();
+	CharacterRotation = Snapshot.ActorRotation;
 
 	const FRotator Delta{ UKismetMathLibrary::NormalizedDeltaRotator(CharacterRotation, CharacterRotationLastFrame) };
 
@@ -151,3 +212,68 @@ void UShooterAnimInstance::Lean(float DeltaTime)
 	const float Interp{ FMath::FInterpTo(YawDelta, Target, DeltaTime, 6.f) };
 	YawDelta = FMath::Clamp(Interp, -90.f, 90.f);
 }
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs AnimBenchmarkCommand(
+	TEXT("Shooter.Bench.Anim"),
+	TEXT("Spawn copies of the first player's character and measure the game thread cost of their animation update.\n")
+	TEXT("Usage: Shooter.Bench.Anim [Characters=100] [Frames=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		AShooterCharacter* PlayerCharacter = PlayerController ? Cast<AShooterCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (PlayerCharacter == nullptr)
+		{
+			UE_LOG(LogUltimateShooter, Warning, TEXT("Anim benchmark needs a game world with a shooter character"));
+			return;
+		}
+
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 60;
+
+		// Same class as the player's, so the same animation blueprint
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		TArray<AShooterCharacter*> Characters;
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			const FVector Location{ PlayerCharacter->GetActorLocation() + FVector((Index % 10 + 1) * 200.f, (Index / 10) * 200.f, 0.f) };
+			if (AShooterCharacter* Character = World->SpawnActor<AShooterCharacter>(PlayerCharacter->GetClass(), FTransform(Location), SpawnParameters))
+			{
+				Characters.Add(Character);
+			}
+		}
+
+		// Needing valid root motion forces the whole update onto the calling thread, the way the event graph ran it
+		auto TimeUpdates = [&Characters, NumFrames](bool bInline)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (AShooterCharacter* Character : Characters)
+				{
+					Character->GetMesh()->TickAnimation(1.f / 60.f, bInline);
+				}
+			}
+			return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+		};
+		const double InlineMs = TimeUpdates(true);
+		const double GameThreadMs = TimeUpdates(false);
+
+		const double NumSamples = static_cast<double>(Characters.Num()) * NumFrames;
+		UE_LOG(LogUltimateShooter, Log, TEXT("Anim benchmark: %d characters, %d frames"), Characters.Num(), NumFrames);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    whole update inline   %8.3f ms per frame %8.3f us per character"),
+			InlineMs / NumFrames,
+			InlineMs * 1000.0 / NumSamples);
+		UE_LOG(LogUltimateShooter, Log, TEXT("    game thread part      %8.3f ms per frame %8.3f us per character"),
+			GameThreadMs / NumFrames,
+			GameThreadMs * 1000.0 / NumSamples);
+
+		for (AShooterCharacter* Character : Characters)
+		{
+			Character->Destroy();
+		}
+	}));
+
+#endif
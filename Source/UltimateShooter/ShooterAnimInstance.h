@@ -17,8 +17,25 @@ enum class EOffsetState : uint8
 	EOS_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
+/* Everything the animation update needs from the character, copied on the game thread */
+struct FShooterAnimSnapshot
+{
+	bool bValid{ false };
+
+	FVector Velocity{ FVector::ZeroVector };
+	FRotator ActorRotation{ FRotator::ZeroRotator };
+	FRotator BaseAimRotation{ FRotator::ZeroRotator };
+
+	bool bIsFalling{ false };
+	bool bIsAccelerating{ false };
+	bool bAiming{ false };
+	bool bCrouching{ false };
+	bool bReloading{ false };
+};
+
 /**
- * 
+ * Splits the update in two: NativeUpdateAnimation copies what it needs from the character on the game thread,
+ * NativeThreadSafeUpdateAnimation turns that into the properties the anim graph reads on a worker thread
  */
 UCLASS()
 class ULTIMATESHOOTER_API UShooterAnimInstance : public UAnimInstance
@@ -28,18 +45,37 @@ class ULTIMATESHOOTER_API UShooterAnimInstance : public UAnimInstance
 public:
 	UShooterAnimInstance();
 
-	UFUNCTION(BlueprintCallable)
+	/**
+	 * Properties are updated natively now. Event graphs that still call this get the properties updated right away on the
+	 * game thread, as before, and that frame's thread safe update is skipped
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DeprecatedFunction, DeprecationMessage = "Updated natively, remove the call from the event graph"))
 	void UpdateAnimationProperties(float DeltaTime);
 
 	virtual void NativeInitializeAnimation() override;
 
+	/* Game thread, fills Snapshot */
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+	/* Any thread, reads only Snapshot and the instance's own properties */
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
 protected:
+	/* Turn Snapshot into the properties the anim graph reads */
+	void UpdateFromSnapshot(float DeltaSeconds);
+
 	/* Handle turning in place variables */
 	void TurnInPlace();
 
 	/* Handle calculations for leaning when running */
 	void Lean(float DeltaTime);
 private:
+	/* Character state for the next thread safe update */
+	FShooterAnimSnapshot Snapshot;
+
+	/* True if the event graph already updated the properties from this frame's Snapshot, see UpdateAnimationProperties */
+	bool bUpdatedFromEventGraph;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	class AShooterCharacter* ShooterCharacter;
 
@@ -2,22 +2,92 @@
 
 
 #include "ShooterCharacter.h"
-#include "DrawDebugHelpers.h"
+#include "UltimateShooter.h"
 #include "Item.h"
 #include "Weapon.h"
+#include "Ammo.h"
+#include "EffectPoolSubsystem.h"
+#include "LagCompensationSubsystem.h"
+#include "BallisticProjectileSubsystem.h"
+#include "ItemGridSubsystem.h"
+#include "ItemPoolSubsystem.h"
+#include "AssetStreamingSubsystem.h"
+#include "PickupWidget.h"
+#include "ShooterHUD.h"
+#include "ShooterDiagnosticsSubsystem.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/DamageType.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundCue.h"
 #include "Engine/SkeletalMeshSocket.h"
+#include "Particles/ParticleSystem.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "Animation/AnimMontage.h"
 #include "Components/WidgetComponent.h"
-#include "Components/SphereComponent.h"
+#include "Components/CapsuleComponent.h"
 #include "Components/BoxComponent.h"
 
+static TAutoConsoleVariable<bool> CVarAsyncHitscan(
+	TEXT("Shooter.AsyncHitscan"),
+	false,
+	TEXT("Queue hitscan shots as async traces and resolve them on the following frames.\n")
+	TEXT("False traces every shot synchronously on the game thread."));
+
+static TAutoConsoleVariable<float> CVarShotsMaxBarrelError(
+	TEXT("Shooter.Shots.MaxBarrelError"),
+	150.f,
+	TEXT("Furthest a remote client's barrel location may be from the server's before its shot is rejected."));
+
+static TAutoConsoleVariable<float> CVarShotsTimeTolerance(
+	TEXT("Shooter.Shots.TimeTolerance"),
+	0.05f,
+	TEXT("Seconds a remote client's shot time may be ahead of the server clock, or early for the fire rate, before the shot is rejected."));
+
+static TAutoConsoleVariable<float> CVarPickupMaxReachError(
+	TEXT("Shooter.Pickup.MaxReachError"),
+	200.f,
+	TEXT("How far outside an item's pickup radius the server still lets a remote client pick it up, covers movement the server hasn't seen yet."));
+
+static TAutoConsoleVariable<bool> CVarCharacterDormantTickWork(
+	TEXT("Shooter.Character.DormantTickWork"),
+	true,
+	TEXT("Let camera zoom, crosshair spread and the item trace sleep in character Tick once they settle.\n")
+	TEXT("False runs all of them every tick."));
+
+DECLARE_CYCLE_STAT(TEXT("SendBullet"), STAT_SendBullet, STATGROUP_UltimateShooter);
+DECLARE_CYCLE_STAT(TEXT("ProcessHitscanShots"), STAT_ProcessHitscanShots, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Hitscan Shots"), STAT_PendingHitscanShots, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Traces"), STAT_CrosshairTraces, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Trace Cache Hits"), STAT_CrosshairTraceCacheHits, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Zoom Active"), STAT_CameraZoomActive, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Zoom Dormant"), STAT_CameraZoomDormant, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Spread Active"), STAT_CrosshairSpreadActive, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Spread Dormant"), STAT_CrosshairSpreadDormant, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Trace Active"), STAT_ItemTraceActive, STATGROUP_UltimateShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Trace Dormant"), STAT_ItemTraceDormant, STATGROUP_UltimateShooter);
+
+/* How close interpolated values have to get to their target before they snap to it and go dormant */
+static constexpr float CameraFOVTolerance = 0.01f;
+static constexpr float CrosshairFactorTolerance = 0.001f;
+
+/* Planar speed change in cm/s that wakes the crosshair spread up */
+static constexpr float SpreadSpeedTolerance = 1.f;
+
 // Sets default values
 AShooterCharacter::AShooterCharacter() :
+	EffectPoolPrewarmCount(8),
+	DefaultWeaponPrewarmCount(2),
+	Significance(ESignificance::ES_High),
+	ActiveTickWork(ECharacterTickWork::All),
+	SpreadSpeed(0.f),
+	ItemTraceCameraLocation(FVector::ZeroVector),
+	ItemTraceCameraRotation(FQuat::Identity),
+	ItemTraceGridRevision(0),
 	// Base rates for turning/looking up
 	BaseTurnRate(45.f),
 	BaseLookUpRate(45.f),
@@ -51,6 +121,8 @@ AShooterCharacter::AShooterCharacter() :
 	bFireButtonPressed(false),
 	bShouldFire(true),
 	AutomaticFireRate(0.1f),
+	bHasPreviousTickAim(false),
+	FireWeaponFrame(0),
 	// Item trace variables
 	bShouldTraceForItems(false),
 	// Camera interp location variables
@@ -58,8 +130,11 @@ AShooterCharacter::AShooterCharacter() :
 	CameraInterpElevation(75.f),
 	Starting9mmAmmo(120),
 	StartingARAmmo(85),
+	StartingShellsAmmo(24),
 	CombatState(ECombatState::ECS_Unoccupied),
-	bCrouching(false)
+	bCrouching(false),
+	RightHandSocket(FName("RightHandSocket")),
+	LeftHandBone(FName("hand_l"))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -76,6 +151,15 @@ AShooterCharacter::AShooterCharacter() :
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);  // Attach camera to end ob Boom
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	// One pickup widget, moved to whichever item the player looks at
+	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
+	PickupWidget->SetupAttachment(RootComponent);
+	PickupWidget->SetWidgetSpace(EWidgetSpace::Screen);
+	PickupWidget->SetDrawAtDesiredSize(true);
+	PickupWidget->SetVisibility(false);
+	// Its default text layout, until a Blueprint subclass is set
+	PickupWidget->SetWidgetClass(UPickupWidget::StaticClass());
+
 	// Dont rotate when the controller rotates. Let the controller ony affect the camera.
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = true;
@@ -101,11 +185,166 @@ void AShooterCharacter::BeginPlay()
 		CameraDefaultFOV = GetFollowCamera()->FieldOfView;
 		CameraCurrentFOV = CameraDefaultFOV;
 	}
+	// Only changes when aiming starts or stops from here on
+	SetLookRates();
+
+	// Widgets made for the old per item widget components read properties items no longer have
+	if (!PickupWidget->GetWidgetClass() || !PickupWidget->GetWidgetClass()->IsChildOf<UPickupWidget>())
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("%s: pickup widget class %s isn't a UPickupWidget, using the default layout"), *GetName(), *GetNameSafe(PickupWidget->GetWidgetClass()));
+		PickupWidget->SetWidgetClass(UPickupWidget::StaticClass());
+	}
+
+	// Combat assets stream in rather than loading with the map, until then shots go without them
+	if (UAssetStreamingSubsystem* AssetStreaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+	{
+		CombatAssetsHandle = AssetStreaming->RequestAssets(
+			{
+				FireSound.ToSoftObjectPath(),
+				MuzzleFlash.ToSoftObjectPath(),
+				HipFireMontage.ToSoftObjectPath(),
+				ImpactParticles.ToSoftObjectPath(),
+				BeamParticles.ToSoftObjectPath(),
+				ReloadMontage.ToSoftObjectPath()
+			},
+			FStreamableDelegate::CreateUObject(this, &AShooterCharacter::OnCombatAssetsLoaded),
+			GetName()
+		);
+	}
+	UpdateItemAssetPrefetch();
+
+	// Ammo first, so anyone told about the equiped weapon already sees what the character carries for it
+	InitializeAmmoMap();
 
 	// Spawn the default weapon and equip it
 	EquipWeapon(SpawnDefaultWeapon());
 
-	InitializeAmmoMap();
+	// Refill the pool this character took its weapon from, for whoever spawns or respawns next
+	if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		ItemPool->Prewarm(DefaultWeaponClass, DefaultWeaponPrewarmCount);
+	}
+
+	// Record hitbox history so shots from remote players can be rewound
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->RegisterCharacter(this);
+	}
+
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
+	{
+		SignificanceSubsystem->RegisterActor(this, FOnSignificanceChanged::CreateUObject(this, &AShooterCharacter::SetSignificance));
+	}
+}
+
+void AShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
+	{
+		SignificanceSubsystem->UnregisterActor(this);
+	}
+
+	// Hand the weapon back to the pool when the character goes away mid game
+	if (EndPlayReason == EEndPlayReason::Destroyed && EquipedWeapon)
+	{
+		EquipedWeapon->StopFireLoop();
+		UItemPoolSubsystem::DespawnItem(EquipedWeapon);
+		EquipedWeapon = nullptr;
+	}
+
+	if (CombatAssetsHandle.IsValid())
+	{
+		CombatAssetsHandle->ReleaseHandle();
+		CombatAssetsHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShooterCharacter::OnCombatAssetsLoaded()
+{
+	// Have pooled components ready before the first shot
+	if (UEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UEffectPoolSubsystem>())
+	{
+		EffectPool->Prewarm(MuzzleFlash.Get(), EffectPoolPrewarmCount);
+		EffectPool->Prewarm(ImpactParticles.Get(), EffectPoolPrewarmCount);
+		EffectPool->Prewarm(BeamParticles.Get(), EffectPoolPrewarmCount);
+	}
+}
+
+void AShooterCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	RightHandSocket.Resolve(GetMesh());
+	LeftHandBone.Resolve(GetMesh());
+}
+
+void AShooterCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// A new player's HUD starts from the current spread rather than waiting for it to change
+	PushCrosshairSpread();
+
+	UpdateItemAssetPrefetch();
+
+	if (USignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<USignificanceSubsystem>())
+	{
+		SignificanceSubsystem->RefreshActor(this);
+	}
+}
+
+void AShooterCharacter::SetSignificance(ESignificance NewSignificance)
+{
+	Significance = NewSignificance;
+
+	const float TickInterval = USignificanceSubsystem::GetTickInterval(Significance);
+	SetActorTickInterval(TickInterval);
+
+	// Animation updates at the same rate as the rest of the character. A listen server checks and rewinds remote
+	// clients' shots against these poses, so there only the cosmetic actor tick work is throttled
+	GetMesh()->SetComponentTickInterval(IsNetMode(NM_ListenServer) ? 0.f : TickInterval);
+
+	// Only the top tier traces for items, coming back into it needs a fresh trace
+	WakeTickWork(ECharacterTickWork::ItemTrace);
+}
+
+void AShooterCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+
+	WakeTickWork(ECharacterTickWork::CrosshairSpread);
+}
+
+void AShooterCharacter::PollTickWorkInputs()
+{
+	if (!CVarCharacterDormantTickWork.GetValueOnGameThread())
+	{
+		ActiveTickWork = ECharacterTickWork::All;
+		return;
+	}
+
+	if (!EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::CrosshairSpread) &&
+		!FMath::IsNearlyEqual(GetVelocity().Size2D(), SpreadSpeed, SpreadSpeedTolerance))
+	{
+		WakeTickWork(ECharacterTickWork::CrosshairSpread);
+	}
+
+	if (!EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::ItemTrace))
+	{
+		const UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>();
+		if ((ItemGrid && ItemGrid->GetRevision() != ItemTraceGridRevision) ||
+			!FollowCamera->GetComponentLocation().Equals(ItemTraceCameraLocation) ||
+			!FollowCamera->GetComponentQuat().Equals(ItemTraceCameraRotation))
+		{
+			WakeTickWork(ECharacterTickWork::ItemTrace);
+		}
+	}
 }
 
 void AShooterCharacter::MoveForward(float Value)
@@ -178,77 +417,475 @@ void AShooterCharacter::FireWeapon()
 	if (EquipedWeapon == nullptr) return;
 	if (CombatState != ECombatState::ECS_Unoccupied) return;
 	if (WeaponHasAmmo()) {
+		FShotAim Aim;
+		const bool bHasAim = GetShotAim(Aim);
+
 		PlayFireSound();
-		SendBullet();
+		if (bHasAim)
+		{
+			SendBullet(Aim);
+		}
+		StartCrosshairBulletFire();
 		PlayGunfireMontage();
 		EquipedWeapon->DecrementAmmo();
 
+		if (bHasAim)
+		{
+			PreviousTickAim = Aim;
+		}
+		bHasPreviousTickAim = bHasAim;
 		StartFireTimer();
 	}
 }
 
-bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation)
+void AShooterCharacter::GetCrosshairTarget(const FShotAim& Aim, FVector& OutTarget)
 {
 
 	/* Check for crosshair trace hit */
 	FHitResult CrosshairHitResult;
-	bool bCrosshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutBeamLocation);
+	bool bCrosshairHit = false;
+	if (Aim.bCurrentFrame)
+	{
+		// Shares this frame's crosshair trace with everything else that asked for it
+		bCrosshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutTarget);
+	}
+	else
+	{
+		// Interpolated aim between two frames, needs a trace of its own
+		GetWorld()->LineTraceSingleByChannel(CrosshairHitResult, Aim.CrosshairStart, Aim.CrosshairEnd, ECollisionChannel::ECC_Visibility);
+		bCrosshairHit = CrosshairHitResult.bBlockingHit;
+	}
 
 	if (bCrosshairHit)
 	{
 		// Tentative beam location - still need to trace from gun
-		OutBeamLocation == CrosshairHitResult.Location;
+		OutTarget = CrosshairHitResult.Location;
 	}
 	else // no crosshair trace hit
 	{
 		// Out beam location is the end location for the line trace
+		OutTarget = Aim.CrosshairEnd;
+	}
+}
+
+FPelletPattern AShooterCharacter::GetPelletPattern() const
+{
+	FPelletPattern Pattern;
+	Pattern.PelletCount = FMath::Clamp(EquipedWeapon->GetPelletCount(), 1, MaxPelletsPerShot);
+	Pattern.ConeHalfAngle = FMath::DegreesToRadians(EquipedWeapon->GetPelletSpread() * GetCrosshairSpreadMultiplier());
+	Pattern.PelletDamage = EquipedWeapon->GetDamage();
+	return Pattern;
+}
+
+void AShooterCharacter::TracePellets(const FShotAim& Aim, const TOptional<double>& RewindTime)
+{
+	ULagCompensationSubsystem* LagCompensation = RewindTime.IsSet() ? GetWorld()->GetSubsystem<ULagCompensationSubsystem>() : nullptr;
+
+	FVector Target;
+	if (LagCompensation)
+	{
+		// The crosshair found its target among characters where the shooter saw them too
+		FHitResult CrosshairHitResult;
+		const bool bCrosshairHit = LagCompensation->LineTraceRewound(
+			RewindTime.GetValue(),
+			this,
+			CrosshairHitResult,
+			Aim.CrosshairStart,
+			Aim.CrosshairEnd,
+			ECollisionChannel::ECC_Visibility
+		);
+		Target = bCrosshairHit ? FVector(CrosshairHitResult.Location) : Aim.CrosshairEnd;
 	}
+	else
+	{
+		GetCrosshairTarget(Aim, Target);
+	}
+
+	// Perform a second trace per pellet, this time from a gun barrel
+	const FPelletPattern Pellets{ GetPelletPattern() };
+	const FVector WeaponTraceStart{ Aim.SocketTransform.GetLocation() };
+	FPelletTraceEnds WeaponTraceEnds;
+	Pellets.GetTraceEnds(WeaponTraceStart, Target, WeaponTraceEnds);
+
+	FPelletHits PelletHits;
+	PelletHits.SetNum(WeaponTraceEnds.Num());
+	if (LagCompensation)
+	{
+		// Hit what the shooter saw, not where targets are on the server now. One rewind covers every pellet
+		LagCompensation->LineTracesRewound(
+			RewindTime.GetValue(),
+			this,
+			PelletHits,
+			WeaponTraceStart,
+			WeaponTraceEnds,
+			ECollisionChannel::ECC_Visibility
+		);
+	}
+	else
+	{
+		for (int32 Pellet = 0; Pellet < WeaponTraceEnds.Num(); ++Pellet)
+		{
+			GetWorld()->LineTraceSingleByChannel(
+				PelletHits[Pellet],
+				WeaponTraceStart,
+				WeaponTraceEnds[Pellet],
+				ECollisionChannel::ECC_Visibility
+			);
+		}
+	}
+
+	ApplyPelletHits(Aim.SocketTransform, PelletHits, Pellets.PelletDamage);
+}
 
-	// Perform a second trace, this time from a gun barrel
-	FHitResult WeapoTraceHit;
-	const FVector WeaponTraceStart{ MuzzleSocketLocation };
-	const FVector StartToEnd{ OutBeamLocation - MuzzleSocketLocation };
-	const FVector WeaponTraceEnd{ MuzzleSocketLocation + StartToEnd * 1.25f };
-	GetWorld()->LineTraceSingleByChannel(
-		WeapoTraceHit,
-		WeaponTraceStart,
-		WeaponTraceEnd,
+void AShooterCharacter::ApplyPelletHits(const FTransform& SocketTransform, TArrayView<const FHitResult> PelletHits, float PelletDamage)
+{
+	/* Pellets of the shot that hit the same actor */
+	struct FActorHit
+	{
+		AActor* Actor;
+		const FHitResult* FirstHit;
+		int32 NumPellets;
+	};
+
+	// Pellets are few, a linear search beats hashing
+	TArray<FActorHit, TInlineAllocator<MaxPelletsPerShot>> ActorHits;
+	for (const FHitResult& PelletHit : PelletHits)
+	{
+		if (!PelletHit.bBlockingHit) continue; // object between barrel and BeamEndPoint?
+
+		AActor* HitActor = PelletHit.GetActor();
+		if (FActorHit* ActorHit = ActorHits.FindByPredicate([HitActor](const FActorHit& Entry) { return Entry.Actor == HitActor; }))
+		{
+			++ActorHit->NumPellets;
+		}
+		else
+		{
+			ActorHits.Add({ HitActor, &PelletHit, 1 });
+		}
+	}
+
+	// One impact, one beam and one damage event per actor, however many pellets hit it
+	for (const FActorHit& ActorHit : ActorHits)
+	{
+		const FHitResult& Hit = *ActorHit.FirstHit;
+		SpawnBulletEffects(SocketTransform, Hit.Location);
+
+		if (ActorHit.Actor && PelletDamage > 0.f && HasAuthority())
+		{
+			UGameplayStatics::ApplyPointDamage(
+				ActorHit.Actor,
+				PelletDamage * ActorHit.NumPellets,
+				(Hit.TraceEnd - Hit.TraceStart).GetSafeNormal(),
+				Hit,
+				GetController(),
+				this,
+				UDamageType::StaticClass()
+			);
+		}
+	}
+}
+
+double AShooterCharacter::GetShotServerTime() const
+{
+	// The game state keeps clients' estimate of the server clock, on the server it is the world time
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+	return GetWorld()->GetTimeSeconds();
+}
+
+void AShooterCharacter::ServerSendBullet_Implementation(FVector_NetQuantize BarrelLocation, FVector_NetQuantize CrosshairStart, FVector_NetQuantize CrosshairEnd, double ShotTime)
+{
+	if (EquipedWeapon == nullptr) return;
+
+	// Nothing the client sends is taken on trust: it fires from where the server has its barrel, with rounds the server
+	// knows about, no faster than the weapon fires and never from the future
+	const float TimeTolerance = CVarShotsTimeTolerance.GetValueOnGameThread();
+	FTransform ServerSocketTransform;
+	const FVector ServerBarrelLocation{ EquipedWeapon->GetBarrelSocketTransform(ServerSocketTransform) ? ServerSocketTransform.GetLocation() : GetActorLocation() };
+	const TCHAR* RejectReason = nullptr;
+	if (CombatState == ECombatState::ECS_Reloading || !WeaponHasAmmo())
+	{
+		RejectReason = TEXT("no rounds in the magazine");
+	}
+	else if (ShotTime > GetShotServerTime() + TimeTolerance)
+	{
+		RejectReason = TEXT("shot time in the future");
+	}
+	else if (FVector::DistSquared(ServerBarrelLocation, BarrelLocation) > FMath::Square(CVarShotsMaxBarrelError.GetValueOnGameThread()))
+	{
+		RejectReason = TEXT("barrel too far from the server's");
+	}
+	else if (!FireScheduler.AcceptRemoteShot(ShotTime, AutomaticFireRate, TimeTolerance))
+	{
+		RejectReason = TEXT("faster than the fire rate");
+	}
+	if (RejectReason)
+	{
+		UE_LOG(LogUltimateShooter, Verbose, TEXT("%s: rejected shot, %s"), *GetName(), RejectReason);
+		return;
+	}
+
+	EquipedWeapon->DecrementAmmo();
+
+	FShotAim Aim;
+	Aim.SocketTransform = FTransform(BarrelLocation);
+	Aim.CrosshairStart = CrosshairStart;
+	Aim.CrosshairEnd = CrosshairEnd;
+
+	if (EquipedWeapon->UsesProjectiles())
+	{
+		// Projectiles fly in server time, their hits need no rewind
+		FireProjectile(Aim);
+	}
+	else
+	{
+		TracePellets(Aim, ShotTime);
+	}
+}
+
+void AShooterCharacter::ServerReloadWeapon_Implementation()
+{
+	ReloadWeapon();
+}
+
+void AShooterCharacter::ServerPickupItem_Implementation(TSubclassOf<AItem> ItemClass, const UItemDefinition* Definition, FVector_NetQuantize ItemLocation)
+{
+	const UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>();
+	if (ItemGrid == nullptr || ItemClass == nullptr) return;
+
+	// Only pickups whose radius reaches the character, the same test the client's item trace starts from
+	TArray<AItem*> NearbyItems;
+	ItemGrid->GetItemsInRange(GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleRadius() + CVarPickupMaxReachError.GetValueOnGameThread(), NearbyItems);
+
+	AItem* ServerItem = nullptr;
+	double ClosestDistanceSquared = TNumericLimits<double>::Max();
+	for (AItem* Item : NearbyItems)
+	{
+		if (Item->GetClass() != ItemClass || Item->GetDefinition() != Definition) continue;
+
+		const double DistanceSquared = FVector::DistSquared(Item->GetActorLocation(), ItemLocation);
+		if (DistanceSquared < ClosestDistanceSquared)
+		{
+			ServerItem = Item;
+			ClosestDistanceSquared = DistanceSquared;
+		}
+	}
+	if (ServerItem == nullptr)
+	{
+		UE_LOG(LogUltimateShooter, Verbose, TEXT("%s: rejected pickup, no %s in reach"), *GetName(), *ItemClass->GetName());
+		return;
+	}
+
+	// Nobody watches the server's copy fly to the camera, it goes straight into the inventory
+	GetPickupItem(ServerItem);
+}
+
+void AShooterCharacter::QueueHitscanShot(const FShotAim& Aim)
+{
+	FHitscanShot& Shot = PendingHitscanShots.AddDefaulted_GetRef();
+	Shot.SocketTransform = Aim.SocketTransform;
+	Shot.Pellets = GetPelletPattern();
+
+	if (Aim.bCurrentFrame && CrosshairTraceCache.bTraced)
+	{
+		// Crosshair was already traced this frame, go straight to the barrel traces
+		const FHitResult& CrosshairHitResult = CrosshairTraceCache.HitResult;
+		Shot.BeamEnd = CrosshairHitResult.bBlockingHit ? FVector(CrosshairHitResult.Location) : Aim.CrosshairEnd;
+		QueuePelletTraces(Shot);
+		return;
+	}
+
+	// Until the crosshair trace resolves the beam ends at the far end of the trace
+	Shot.BeamEnd = Aim.CrosshairEnd;
+	Shot.CrosshairTraceHandle = GetWorld()->AsyncLineTraceByChannel(
+		EAsyncTraceType::Single,
+		Aim.CrosshairStart,
+		Aim.CrosshairEnd,
 		ECollisionChannel::ECC_Visibility
 	);
-	if (WeapoTraceHit.bBlockingHit) // object between barrel and BeamEndPoint?
+}
+
+void AShooterCharacter::QueuePelletTraces(FHitscanShot& Shot)
+{
+	// Second trace per pellet, this time from the gun barrel
+	const FVector WeaponTraceStart{ Shot.SocketTransform.GetLocation() };
+	FPelletTraceEnds WeaponTraceEnds;
+	Shot.Pellets.GetTraceEnds(WeaponTraceStart, Shot.BeamEnd, WeaponTraceEnds);
+
+	// Issued back to back so the whole shot lands in the same async batch and resolves on the same frame
+	Shot.CrosshairTraceHandle = FTraceHandle();
+	Shot.PelletTraceHandles.Reset();
+	for (const FVector& WeaponTraceEnd : WeaponTraceEnds)
 	{
-		OutBeamLocation = WeapoTraceHit.Location;
-		return true;
+		Shot.PelletTraceHandles.Add(GetWorld()->AsyncLineTraceByChannel(
+			EAsyncTraceType::Single,
+			WeaponTraceStart,
+			WeaponTraceEnd,
+			ECollisionChannel::ECC_Visibility
+		));
+	}
+}
+
+void AShooterCharacter::ProcessHitscanShots()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProcessHitscanShots);
+
+	if (PendingHitscanShots.Num() == 0) return;
+
+	UWorld* World = GetWorld();
+	int32 NumPending = 0;
+	for (int32 ShotIndex = 0; ShotIndex < PendingHitscanShots.Num(); ++ShotIndex)
+	{
+		FHitscanShot& Shot = PendingHitscanShots[ShotIndex];
+		bool bShotDone = false;
+
+		if (Shot.CrosshairTraceHandle.IsValid())
+		{
+			FTraceDatum CrosshairDatum;
+			if (World->QueryTraceData(Shot.CrosshairTraceHandle, CrosshairDatum))
+			{
+				if (CrosshairDatum.OutHits.Num() > 0 && CrosshairDatum.OutHits[0].bBlockingHit)
+				{
+					// Tentative beam location - still need to trace from gun
+					Shot.BeamEnd = CrosshairDatum.OutHits[0].Location;
+				}
+				QueuePelletTraces(Shot);
+			}
+			else
+			{
+				// Results only live for one frame, drop the shot if we missed them
+				bShotDone = !World->IsTraceHandleValid(Shot.CrosshairTraceHandle, false);
+			}
+		}
+		else
+		{
+			// Pellets were issued together, so they all resolve on the same frame
+			FPelletHits PelletHits;
+			for (const FTraceHandle& PelletTraceHandle : Shot.PelletTraceHandles)
+			{
+				FTraceDatum PelletDatum;
+				if (!World->QueryTraceData(PelletTraceHandle, PelletDatum))
+				{
+					bShotDone = !World->IsTraceHandleValid(PelletTraceHandle, false);
+					PelletHits.Reset();
+					break;
+				}
+				PelletHits.Add(PelletDatum.OutHits.Num() > 0 ? PelletDatum.OutHits[0] : FHitResult());
+			}
+
+			if (PelletHits.Num() > 0)
+			{
+				ApplyPelletHits(Shot.SocketTransform, PelletHits, Shot.Pellets.PelletDamage);
+				bShotDone = true;
+			}
+		}
+
+		if (!bShotDone)
+		{
+			// Compact the queue in place so shots resolve in the order they were fired
+			if (NumPending != ShotIndex)
+			{
+				PendingHitscanShots[NumPending] = MoveTemp(Shot);
+			}
+			++NumPending;
+		}
+	}
+	PendingHitscanShots.SetNum(NumPending, false);
+
+	INC_DWORD_STAT_BY(STAT_PendingHitscanShots, NumPending);
+}
+
+void AShooterCharacter::FireProjectile(const FShotAim& Aim)
+{
+	UBallisticProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UBallisticProjectileSubsystem>();
+	if (Projectiles == nullptr) return;
+
+	// Aim at whatever is under the crosshair, the current frame's trace is already cached
+	FVector AimTarget{ Aim.CrosshairEnd };
+	if (Aim.bCurrentFrame)
+	{
+		FHitResult CrosshairHitResult;
+		TraceUnderCrosshairs(CrosshairHitResult, AimTarget);
+	}
+
+	const FVector MuzzleLocation{ Aim.SocketTransform.GetLocation() };
+	FPelletTraceEnds PelletTargets;
+	GetPelletPattern().GetTraceEnds(MuzzleLocation, AimTarget, PelletTargets);
+	for (const FVector& PelletTarget : PelletTargets)
+	{
+		const FVector Direction{ (PelletTarget - MuzzleLocation).GetSafeNormal() };
+		Projectiles->FireProjectile(
+			MuzzleLocation,
+			Direction * EquipedWeapon->GetProjectileSpeed(),
+			EquipedWeapon->GetProjectileDrag(),
+			EquipedWeapon->GetDamage(),
+			this,
+			ImpactParticles.Get()
+		);
+	}
+}
+
+void AShooterCharacter::SpawnBulletEffects(const FTransform& SocketTransform, const FVector& BeamEnd)
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::Traces))
+	{
+		UShooterDiagnosticsSubsystem::DrawLine(this, SocketTransform.GetLocation(), BeamEnd, FColor::Orange, 1.f);
+	}
+#endif
+
+	if (UParticleSystem* Impact = ImpactParticles.Get())
+	{
+		UEffectPoolSubsystem::SpawnEffect(
+			this,
+			Impact,
+			FTransform(BeamEnd)
+		);
+	}
+
+	UParticleSystemComponent* Beam = UEffectPoolSubsystem::SpawnEffect(
+		this,
+		BeamParticles.Get(),
+		SocketTransform
+	);
+	if (Beam)
+	{
+		Beam->SetVectorParameter(FName("Target"), BeamEnd);
 	}
-	return false;
 }
 
 void AShooterCharacter::AimingButtonPressed()
 {
 	bAiming = true;
 	GetFollowCamera()->SetFieldOfView(CameraZoomedFOV);
+	SetLookRates();
+	WakeTickWork(ECharacterTickWork::CameraZoom | ECharacterTickWork::CrosshairSpread);
 }
 
 void AShooterCharacter::AimingButtonReleased()
 {
 	bAiming = false;
 	GetFollowCamera()->SetFieldOfView(CameraDefaultFOV);
+	SetLookRates();
+	WakeTickWork(ECharacterTickWork::CameraZoom | ECharacterTickWork::CrosshairSpread);
 }
 
-void AShooterCharacter::CameraInterpZoom(float DeltaTime)
+bool AShooterCharacter::CameraInterpZoom(float DeltaTime)
 {
+	// Zoomed FOV while aiming, default FOV otherwise
+	const float TargetFOV = bAiming ? CameraZoomedFOV : CameraDefaultFOV;
+
 	// Set current camera FOV
-	if (bAiming)
-	{
-		// Interpolate to Zoomed FOV
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraZoomedFOV, DeltaTime, ZoomInterpSpeed);
-	}
-	else
+	CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, TargetFOV, DeltaTime, ZoomInterpSpeed);
+	if (FMath::IsNearlyEqual(CameraCurrentFOV, TargetFOV, CameraFOVTolerance))
 	{
-		// Interpolate to Default FOV
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraDefaultFOV, DeltaTime, ZoomInterpSpeed);
+		CameraCurrentFOV = TargetFOV;
 	}
 	GetFollowCamera()->SetFieldOfView(CameraCurrentFOV);
+
+	return CameraCurrentFOV != TargetFOV;
 }
 
 void AShooterCharacter::SetLookRates()
@@ -265,17 +902,16 @@ void AShooterCharacter::SetLookRates()
 	}
 }
 
-void AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
+bool AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
 {
 	FVector2D WalkSpeedRange{ 0.f, 600.f };
 	FVector2D VelicytyMultiplierRange{ 0.f, 1.f };
-	FVector Velocity{ GetVelocity() };
-	Velocity.Z = 0.f;
+	SpreadSpeed = GetVelocity().Size2D();
 
 	CrosshairVelocityFactor = FMath::GetMappedRangeValueClamped(
 		WalkSpeedRange, 
 		VelicytyMultiplierRange, 
-		Velocity.Size());
+		SpreadSpeed);
 
 	// Calculate crosshair in Air factor
 	if(GetCharacterMovement()->IsFalling()) // is in air?
@@ -315,11 +951,36 @@ void AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
 		CrosshairInAirFactor -
 		CrosshairAimFactor
 		+ CrosshairShootingFactor;
+	PushCrosshairSpread();
+
+	// Snap factors that are close enough, settled once all of them sit on their target
+	auto Settle = [](float& Factor, float Target)
+	{
+		if (FMath::IsNearlyEqual(Factor, Target, CrosshairFactorTolerance))
+		{
+			Factor = Target;
+		}
+		return Factor == Target;
+	};
+	const bool bInAirSettled = Settle(CrosshairInAirFactor, GetCharacterMovement()->IsFalling() ? 2.25f : 0.f);
+	const bool bAimSettled = Settle(CrosshairAimFactor, bAiming ? 0.7f : 0.f);
+	const bool bShootingSettled = Settle(CrosshairShootingFactor, bFiringBullet ? 0.5f : 0.f);
+	return !(bInAirSettled && bAimSettled && bShootingSettled);
+}
+
+void AShooterCharacter::PushCrosshairSpread()
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if (AShooterHUD* ShooterHUD = PlayerController ? Cast<AShooterHUD>(PlayerController->GetHUD()) : nullptr)
+	{
+		ShooterHUD->SetCrosshairSpread(CrosshairSpreadMultiplier);
+	}
 }
 
 void AShooterCharacter::StartCrosshairBulletFire()
 {
 	bFiringBullet = true;
+	WakeTickWork(ECharacterTickWork::CrosshairSpread);
 
 	GetWorldTimerManager().SetTimer(CrosshairShootTimer, this, &AShooterCharacter::FinishCrosshairBulletFire, ShootTimeDuration);
 }
@@ -327,6 +988,7 @@ void AShooterCharacter::StartCrosshairBulletFire()
 void AShooterCharacter::FinishCrosshairBulletFire()
 {
 	bFiringBullet = false;
+	WakeTickWork(ECharacterTickWork::CrosshairSpread);
 }
 
 void AShooterCharacter::FireButtonPressed()
@@ -338,34 +1000,113 @@ void AShooterCharacter::FireButtonPressed()
 void AShooterCharacter::FireButtonReleased()
 {
 	bFireButtonPressed = false;
+
+	if (EquipedWeapon)
+	{
+		EquipedWeapon->StopFireLoop();
+	}
 }
 
 void AShooterCharacter::StartFireTimer()
 {
 	CombatState = ECombatState::ECS_FireTimeInProgress;
 
-	GetWorldTimerManager()
-		.SetTimer(AutoFireTimer, this, &AShooterCharacter::AutoFireReset, AutomaticFireRate);
+	FireScheduler.ShotFired(AutomaticFireRate);
+	FireWeaponFrame = GFrameCounter;
 }
 
-void AShooterCharacter::AutoFireReset()
+void AShooterCharacter::UpdateAutomaticFire(float DeltaTime)
 {
-	CombatState = ECombatState::ECS_Unoccupied;
+	if (CombatState != ECombatState::ECS_FireTimeInProgress) return;
+
+	// FireWeapon ran during input processing, this tick's DeltaTime passed before that shot
+	if (FireWeaponFrame == GFrameCounter) return;
 
-	if (WeaponHasAmmo())
+	FFireScheduler::FShotAlphas ShotAlphas;
+	// Semi automatic weapons only fire again on the next press
+	const bool bTriggerHeld = bFireButtonPressed && WeaponHasAmmo() && EquipedWeapon->IsAutomatic();
+	FireScheduler.Advance(DeltaTime, AutomaticFireRate, bTriggerHeld, ShotAlphas);
+
+	// Track the aim on every tick of the timer, not just the ones that fire, so shot alphas blend across one tick only
+	FShotAim CurrentAim;
+	const bool bHasAim = GetShotAim(CurrentAim);
+
+	if (ShotAlphas.Num() > 0)
 	{
-		if(bFireButtonPressed)
+		int32 ShotsFired = 0;
+		for (const float ShotAlpha : ShotAlphas)
 		{
-			FireWeapon();
+			if (!WeaponHasAmmo()) break;
+
+			PlayFireSound();
+			if (bHasAim)
+			{
+				// Fire from where the barrel and crosshair were when the shot was due
+				SendBullet(bHasPreviousTickAim ? FShotAim::Interpolate(PreviousTickAim, CurrentAim, ShotAlpha) : CurrentAim);
+			}
+			EquipedWeapon->DecrementAmmo();
+			++ShotsFired;
+		}
+
+		if (ShotsFired > 0)
+		{
+			StartCrosshairBulletFire();
+			PlayGunfireMontage();
 		}
 	}
-	else {
-		ReloadWeapon();
+
+	if (bHasAim)
+	{
+		PreviousTickAim = CurrentAim;
+	}
+	bHasPreviousTickAim = bHasAim;
+
+	if (!FireScheduler.IsCoolingDown() || !WeaponHasAmmo())
+	{
+		// Trigger released or out of ammo, the gunfire loop ends with the last shot
+		if (EquipedWeapon)
+		{
+			EquipedWeapon->StopFireLoop();
+		}
+	}
+
+	if (!FireScheduler.IsCoolingDown())
+	{
+		CombatState = ECombatState::ECS_Unoccupied;
+
+		if (!WeaponHasAmmo())
+		{
+			ReloadWeapon();
+		}
 	}
 }
 
-bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation)
+void AShooterCharacter::RefreshCrosshairTraceCache()
 {
+	APlayerController* PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+
+	// Camera view the crosshair is deprojected from
+	FVector CameraLocation{ FVector::ZeroVector };
+	FRotator CameraRotation{ FRotator::ZeroRotator };
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+		CameraRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+	}
+
+	// Still the same frame and view, everything cached is up to date
+	if (CrosshairTraceCache.FrameNumber == GFrameCounter &&
+		CrosshairTraceCache.CameraLocation.Equals(CameraLocation) &&
+		CrosshairTraceCache.CameraRotation.Equals(CameraRotation))
+	{
+		return;
+	}
+
+	CrosshairTraceCache = FCrosshairTraceCache();
+	CrosshairTraceCache.FrameNumber = GFrameCounter;
+	CrosshairTraceCache.CameraLocation = CameraLocation;
+	CrosshairTraceCache.CameraRotation = CameraRotation;
+
 	// Get Viewport Size
 	FVector2D ViewportSize;
 	if (GEngine && GEngine->GameViewport)
@@ -380,7 +1121,7 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 	FVector CrosshairWorldDirection;
 
 	// Get world position and direction of crosshairs
-	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0),
+	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(PlayerController,
 		CrosshairLocation,
 		CrosshairWorldPosition,
 		CrosshairWorldDirection);
@@ -388,14 +1129,61 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 	if (bScreenToWorld)
 	{
 		// Trace from crosshair world location outward
-		const FVector Start{ CrosshairWorldPosition };
-		const FVector End{ Start + CrosshairWorldDirection * 50'000.f };
-		GetWorld()->LineTraceSingleByChannel(OutHitResult, Start, End, ECollisionChannel::ECC_Visibility);
+		CrosshairTraceCache.bHasSegment = true;
+		CrosshairTraceCache.TraceStart = CrosshairWorldPosition;
+		CrosshairTraceCache.TraceEnd = CrosshairWorldPosition + CrosshairWorldDirection * 50'000.f;
+	}
+}
+
+bool AShooterCharacter::GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd)
+{
+	RefreshCrosshairTraceCache();
+
+	OutStart = CrosshairTraceCache.TraceStart;
+	OutEnd = CrosshairTraceCache.TraceEnd;
+	return CrosshairTraceCache.bHasSegment;
+}
+
+bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation)
+{
+	RefreshCrosshairTraceCache();
+
+	if (CrosshairTraceCache.bHasSegment)
+	{
+		// Only the first query this frame pays for the trace
+		if (!CrosshairTraceCache.bTraced)
+		{
+			GetWorld()->LineTraceSingleByChannel(
+				CrosshairTraceCache.HitResult,
+				CrosshairTraceCache.TraceStart,
+				CrosshairTraceCache.TraceEnd,
+				ECollisionChannel::ECC_Visibility);
+			CrosshairTraceCache.bTraced = true;
+			INC_DWORD_STAT(STAT_CrosshairTraces);
+
+#if WITH_SHOOTER_DIAGNOSTICS
+			if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::Traces))
+			{
+				const FHitResult& Hit = CrosshairTraceCache.HitResult;
+				const FVector TraceStop{ Hit.bBlockingHit ? Hit.Location : CrosshairTraceCache.TraceEnd };
+				UShooterDiagnosticsSubsystem::DrawLine(this, CrosshairTraceCache.TraceStart, TraceStop, Hit.bBlockingHit ? FColor::Red : FColor::Green);
+				UShooterDiagnosticsSubsystem::DrawPoint(this, TraceStop, FColor::Red);
+			}
+#endif
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_CrosshairTraceCacheHits);
+		}
+
+		OutHitResult = CrosshairTraceCache.HitResult;
 		if (OutHitResult.bBlockingHit)
 		{
 			OutHitLocation = OutHitResult.Location;
 			return true;
 		}
+		// Without a hit the trace end is the best guess for where we are aiming
+		OutHitLocation = CrosshairTraceCache.TraceEnd;
 	}
 
 	return false;
@@ -403,6 +1191,21 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 
 void AShooterCharacter::TraceForItems()
 {
+	// Characters further out aren't anyone's own, nobody sees their pickup widget
+	if (Significance != ESignificance::ES_High)
+	{
+		bShouldTraceForItems = false;
+		SetPickupWidgetItem(nullptr);
+		return;
+	}
+
+	// Any pickup whose radius reaches the capsule, same as overlapping its area sphere used to be
+	const UItemGridSubsystem* ItemGrid = GetWorld()->GetSubsystem<UItemGridSubsystem>();
+	ItemTraceGridRevision = ItemGrid ? ItemGrid->GetRevision() : 0;
+	ItemTraceCameraLocation = FollowCamera->GetComponentLocation();
+	ItemTraceCameraRotation = FollowCamera->GetComponentQuat();
+	bShouldTraceForItems = ItemGrid && ItemGrid->IsNearItem(GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleRadius());
+
 	if (bShouldTraceForItems) 
 	{
 		FHitResult ItemTraceResult;
@@ -411,42 +1214,74 @@ void AShooterCharacter::TraceForItems()
 		if (ItemTraceResult.bBlockingHit)
 		{
 			TraceHitItem = Cast<AItem>(ItemTraceResult.GetActor());
-			if (TraceHitItem && TraceHitItem->GetPickupWidget())
-			{
-				// Show Item's pickup Widget
-				TraceHitItem->GetPickupWidget()->SetVisibility(true);
-			}
-
-			// We hit an AItem last frame
-			if (TraceHitItemLastFrame)
-			{
-				if (TraceHitItem != TraceHitItemLastFrame)
-				{
-					// We are hitting a different AItem this frame from last frame
-					// Or AItem is null.
-					TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
-				}
-			}
 
 			// Store a reference to HitItem for next frame
 			TraceHitItemLastFrame = TraceHitItem;
 		}
 	}
-	else if (TraceHitItemLastFrame)
+
+	// No longer near any items, item last frame should not show widget.
+	// Items that were picked up or are falling don't show it either
+	AItem* FocusedItem = bShouldTraceForItems ? TraceHitItemLastFrame : nullptr;
+	if (FocusedItem && FocusedItem->GetItemState() != EItemState::EIS_Pickup)
+	{
+		FocusedItem = nullptr;
+	}
+	SetPickupWidgetItem(FocusedItem);
+}
+
+void AShooterCharacter::PrefetchItemAssets()
+{
+	if (UAssetStreamingSubsystem* AssetStreaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+	{
+		AssetStreaming->PrefetchItemsNear(GetActorLocation());
+	}
+}
+
+void AShooterCharacter::UpdateItemAssetPrefetch()
+{
+	// Remote characters' items stream in for their own machine. A dedicated server draws and plays nothing at all
+	const bool bPrefetch = IsLocallyControlled() && !IsNetMode(NM_DedicatedServer) && GetWorld()->GetSubsystem<UAssetStreamingSubsystem>();
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (!bPrefetch)
+	{
+		TimerManager.ClearTimer(ItemAssetPrefetchTimer);
+	}
+	else if (!TimerManager.IsTimerActive(ItemAssetPrefetchTimer))
 	{
-		// No longer overlapping any items,
-		// Item last frame should not show widget
-		TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
+		TimerManager.SetTimer(ItemAssetPrefetchTimer, this, &AShooterCharacter::PrefetchItemAssets, 0.5f, true, 0.f);
 	}
 }
 
+void AShooterCharacter::SetPickupWidgetItem(AItem* Item)
+{
+	if (Item == PickupWidgetItem) return;
+	PickupWidgetItem = Item;
+
+	if (Item == nullptr)
+	{
+		PickupWidget->SetVisibility(false);
+		return;
+	}
+
+	// Show Item's pickup Widget
+	PickupWidget->AttachToComponent(Item->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	PickupWidget->SetRelativeLocation(Item->GetPickupWidgetOffset());
+	if (UPickupWidget* ItemWidget = Cast<UPickupWidget>(PickupWidget->GetUserWidgetObject()))
+	{
+		ItemWidget->SetItem(Item);
+	}
+	PickupWidget->SetVisibility(true);
+}
+
 AWeapon* AShooterCharacter::SpawnDefaultWeapon()
 {
 	// Check subclass variable
 	if (DefaultWeaponClass)
 	{
-		// Spawn Weapon
-		return GetWorld()->SpawnActor<AWeapon>(DefaultWeaponClass);
+		// Spawn Weapon, reusing a parked one when the pool has it
+		return UItemPoolSubsystem::SpawnItem<AWeapon>(this, DefaultWeaponClass, FTransform::Identity);
 	}
 	return nullptr;
 }
@@ -457,14 +1292,21 @@ void AShooterCharacter::EquipWeapon(AWeapon* WeaponToEquip)
 		
 
 		// Get right hand socket
-		const USkeletalMeshSocket* HandSocket = GetMesh()->GetSocketByName(FName("RightHandSocket"));
-		if (HandSocket)
+		if (RightHandSocket.Validate(GetMesh()) && RightHandSocket.GetSocket())
 		{
 			// Attach the weapon to the socket
-			HandSocket->AttachActor(WeaponToEquip, GetMesh());
+			RightHandSocket.GetSocket()->AttachActor(WeaponToEquip, GetMesh());
 		}
 		EquipedWeapon = WeaponToEquip;
 		EquipedWeapon->SetItemState(EItemState::EIS_Equiped);
+
+		// Normally requested as the weapon came near, not for the default weapon
+		if (UAssetStreamingSubsystem* AssetStreaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+		{
+			AssetStreaming->RequestDefinitionAssets(EquipedWeapon->GetDefinition());
+		}
+
+		EquipedWeaponChangedEvent.Broadcast(EquipedWeapon);
 	}
 }
 
@@ -474,6 +1316,7 @@ void AShooterCharacter::DropWeapon()
 	{
 		FDetachmentTransformRules DetachmentTransformRules(EDetachmentRule::KeepWorld, true);
 
+		EquipedWeapon->StopFireLoop();
 		EquipedWeapon->GetItemMesh()->DetachFromComponent(DetachmentTransformRules);
 		EquipedWeapon->SetItemState(EItemState::EIS_Falling);
 		EquipedWeapon->ThrowWeapon();
@@ -484,6 +1327,11 @@ void AShooterCharacter::SelectButtonPressed()
 {
 	if(TraceHitItem)
 	{
+		if (!HasAuthority() && IsLocallyControlled())
+		{
+			// The server swaps weapons and adds ammo on its side too, shots are checked against what it has
+			ServerPickupItem(TraceHitItem->GetClass(), TraceHitItem->GetDefinition(), TraceHitItem->GetActorLocation());
+		}
 		TraceHitItem->StartItemCurve(this);
 
 		if (TraceHitItem->GetPickupSound()) 
@@ -509,6 +1357,12 @@ void AShooterCharacter::InitializeAmmoMap()
 {
 	AmmoMap.Add(EAmmoType::EAT_9mm, Starting9mmAmmo);
 	AmmoMap.Add(EAmmoType::EAT_AR, StartingARAmmo);
+	AmmoMap.Add(EAmmoType::EAT_Shells, StartingShellsAmmo);
+
+	for (const TPair<EAmmoType, int32>& Ammo : AmmoMap)
+	{
+		CarriedAmmoChangedEvent.Broadcast(Ammo.Key, Ammo.Value);
+	}
 }
 
 bool AShooterCharacter::WeaponHasAmmo()
@@ -519,57 +1373,73 @@ bool AShooterCharacter::WeaponHasAmmo()
 
 void AShooterCharacter::PlayFireSound()
 {
-	if (FireSound)
+	if (EquipedWeapon && EquipedWeapon->UsesFireLoop())
 	{
-		UGameplayStatics::PlaySound2D(this, FireSound);
+		// One voice for the whole burst
+		EquipedWeapon->StartFireLoop();
+	}
+	else if (USoundCue* Sound = FireSound.Get())
+	{
+		UGameplayStatics::PlaySound2D(this, Sound);
 	}
 }
 
-void AShooterCharacter::SendBullet()
+bool AShooterCharacter::GetShotAim(FShotAim& OutAim)
 {
-	const USkeletalMeshSocket* BarrelSocket = EquipedWeapon->GetItemMesh()->GetSocketByName("BarrelSocket");
-	if (BarrelSocket)
+	if (!EquipedWeapon->GetBarrelSocketTransform(OutAim.SocketTransform)) return false;
+
+	OutAim.ShotTime = GetShotServerTime();
+	OutAim.bCurrentFrame = GetCrosshairTraceSegment(OutAim.CrosshairStart, OutAim.CrosshairEnd);
+	if (!OutAim.bCurrentFrame)
 	{
-		const FTransform SocketTransform = BarrelSocket->GetSocketTransform(EquipedWeapon->GetItemMesh());
-		if (MuzzleFlash)
-		{
-			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), MuzzleFlash, SocketTransform);
-		}
+		// No viewport to deproject the crosshair from, aim straight out of the barrel
+		OutAim.CrosshairStart = OutAim.SocketTransform.GetLocation();
+		OutAim.CrosshairEnd = OutAim.CrosshairStart + OutAim.SocketTransform.GetRotation().GetForwardVector() * 50'000.f;
+	}
+	return true;
+}
 
-		FVector BeamEnd;
-		bool bBeamEnd = GetBeamEndLocation(SocketTransform.GetLocation(), BeamEnd);
-		if (bBeamEnd) {
-			if (ImpactParticles)
-			{
-				UGameplayStatics::SpawnEmitterAtLocation(
-					GetWorld(),
-					ImpactParticles,
-					BeamEnd
-				);
-			}
+void AShooterCharacter::SendBullet(const FShotAim& Aim)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SendBullet);
 
-			UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(
-				GetWorld(),
-				BeamParticles,
-				SocketTransform
-			);
-			if (Beam)
-			{
-				Beam->SetVectorParameter(FName("Target"), BeamEnd);
-			}
-		}
+	if (UParticleSystem* Flash = MuzzleFlash.Get())
+	{
+		UEffectPoolSubsystem::SpawnEffect(this, Flash, Aim.SocketTransform);
+	}
+
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		// The server decides what a client's shot hit, rewinding hitscan targets to the time it was fired. The local shot below is for effects
+		ServerSendBullet(Aim.SocketTransform.GetLocation(), Aim.CrosshairStart, Aim.CrosshairEnd, Aim.ShotTime);
+	}
+
+	if (EquipedWeapon->UsesProjectiles())
+	{
+		// Impact and damage are handled by the projectile manager when the bullet hits
+		FireProjectile(Aim);
+		return;
 	}
 
-	StartCrosshairBulletFire();
+	if (CVarAsyncHitscan.GetValueOnGameThread())
+	{
+		// Impact and beam are spawned once the traces resolve
+		QueueHitscanShot(Aim);
+	}
+	else
+	{
+		TracePellets(Aim);
+	}
 }
 
 void AShooterCharacter::PlayGunfireMontage()
 {
 	// Play Hip Fire Montage
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-	if (AnimInstance && HipFireMontage)
+	UAnimMontage* Montage = HipFireMontage.Get();
+	if (AnimInstance && Montage)
 	{
-		AnimInstance->Montage_Play(HipFireMontage);
+		AnimInstance->Montage_Play(Montage);
 		AnimInstance->Montage_JumpToSection(FName("StartFire"));
 	}
 }
@@ -588,12 +1458,23 @@ void AShooterCharacter::ReloadWeapon()
 	if(CarryingAmmo() && !EquipedWeapon->ClipIsFull()) 
 	{
 		CombatState = ECombatState::ECS_Reloading;
+		if (!HasAuthority() && IsLocallyControlled())
+		{
+			ServerReloadWeapon();
+		}
+
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-		if (AnimInstance && ReloadMontage)
+		UAnimMontage* Montage = ReloadMontage.Get();
+		if (AnimInstance && Montage)
 		{
-			AnimInstance->Montage_Play(ReloadMontage);
+			AnimInstance->Montage_Play(Montage);
 			AnimInstance->Montage_JumpToSection(EquipedWeapon->GetReloadMontageSection());
 		}
+		else
+		{
+			// Nothing to send the finish notify, reload right away rather than staying stuck in ECS_Reloading
+			FinishReloading();
+		}
 	}
 }
 
@@ -625,9 +1506,16 @@ void AShooterCharacter::FinishReloading()
 			CarriedAmmo -= MagEmptySpace;
 		}
 		AmmoMap.Add(AmmoType, CarriedAmmo);
+		CarriedAmmoChangedEvent.Broadcast(AmmoType, CarriedAmmo);
 	}
 }
 
+int32 AShooterCharacter::GetCarriedAmmo(EAmmoType AmmoType) const
+{
+	const int32* CarriedAmmo = AmmoMap.Find(AmmoType);
+	return CarriedAmmo ? *CarriedAmmo : 0;
+}
+
 bool AShooterCharacter::CarryingAmmo()
 {
 	if (EquipedWeapon == nullptr) return false;
@@ -646,13 +1534,13 @@ void AShooterCharacter::GrabClip()
 	if (EquipedWeapon == nullptr) return;
 	if (HandSceneComponent == nullptr) return;
 	
-	// Index for the clip bone on equiped weapon
-	int32 ClipBoneIndex{ EquipedWeapon->GetItemMesh()->GetBoneIndex(EquipedWeapon->GetClipBoneName()) };
 	// Store the transform of the clip
-	ClipTransform = EquipedWeapon->GetItemMesh()->GetBoneTransform(ClipBoneIndex);
+	if (!EquipedWeapon->GetClipBoneTransform(ClipTransform)) return;
+
+	if (!LeftHandBone.Validate(GetMesh())) return;
 
 	FAttachmentTransformRules AttachmentRules(EAttachmentRule::KeepRelative, true);
-	HandSceneComponent->AttachToComponent(GetMesh(), AttachmentRules, FName(TEXT("hand_l")));
+	HandSceneComponent->AttachToComponent(GetMesh(), AttachmentRules, LeftHandBone.GetName());
 	HandSceneComponent->SetWorldTransform(ClipTransform);
 
 	EquipedWeapon->SetMovingClip(true);
@@ -676,14 +1564,64 @@ void AShooterCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// Wake up settled work whose inputs changed without an event to tell
+	PollTickWorkInputs();
+
 	// Handle zoom interpolation when character is aiming
-	CameraInterpZoom(DeltaTime);
-	// Change look sensivity based on aiming
-	SetLookRates();
+	if (EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::CameraZoom))
+	{
+		INC_DWORD_STAT(STAT_CameraZoomActive);
+		if (!CameraInterpZoom(DeltaTime))
+		{
+			ActiveTickWork &= ~ECharacterTickWork::CameraZoom;
+		}
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_CameraZoomDormant);
+	}
+	// Fire automatic shots that became due since last tick
+	UpdateAutomaticFire(DeltaTime);
 	// Calculate crosshair spread multiplier
-	CalculateCrosshairSpread(DeltaTime);
-	// Check OverlappedItemCount, then trace for items
-	TraceForItems();
+	if (EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::CrosshairSpread))
+	{
+		INC_DWORD_STAT(STAT_CrosshairSpreadActive);
+		if (!CalculateCrosshairSpread(DeltaTime))
+		{
+			ActiveTickWork &= ~ECharacterTickWork::CrosshairSpread;
+		}
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_CrosshairSpreadDormant);
+	}
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::CrosshairSpread) && IsLocallyControlled())
+	{
+		UShooterDiagnosticsSubsystem::AddMessage(
+			EShooterDebugCategory::CrosshairSpread,
+			FString::Printf(TEXT("Crosshair spread %.2f%s: velocity %.2f, in air %.2f, aim %.2f, shooting %.2f"),
+				CrosshairSpreadMultiplier,
+				EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::CrosshairSpread) ? TEXT("") : TEXT(" (settled)"),
+				CrosshairVelocityFactor,
+				CrosshairInAirFactor,
+				CrosshairAimFactor,
+				CrosshairShootingFactor));
+	}
+#endif
+	// Check the item grid, then trace for items. Settles right away until the camera or the grid change
+	if (EnumHasAnyFlags(ActiveTickWork, ECharacterTickWork::ItemTrace))
+	{
+		INC_DWORD_STAT(STAT_ItemTraceActive);
+		TraceForItems();
+		ActiveTickWork &= ~ECharacterTickWork::ItemTrace;
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_ItemTraceDormant);
+	}
+	// Resolve async hitscan traces fired on previous frames
+	ProcessHitscanShots();
 }
 
 // Called to bind functionality to input
@@ -720,20 +1658,6 @@ float AShooterCharacter::GetCrosshairSpreadMultiplier() const
 	return CrosshairSpreadMultiplier;
 }
 
-void AShooterCharacter::IncrementOverlappedItemCount(int8 Amount)
-{
-	if (OverlappedItemCount + Amount <= 0)
-	{
-		OverlappedItemCount = 0;
-		bShouldTraceForItems = false;
-	}
-	else
-	{
-		OverlappedItemCount += Amount;
-		bShouldTraceForItems = true;
-	}
-}
-
 FVector AShooterCharacter::GetCameraInterpLocation()
 {
 	const FVector CameraWorldLocation{ FollowCamera->GetComponentLocation() };
@@ -749,10 +1673,36 @@ void AShooterCharacter::GetPickupItem(AItem* Item)
 	auto Weapon = Cast<AWeapon>(Item);
 	if (Weapon) {
 		SwapWeapon(Weapon);
-		if (Item->GetEquipSound())
+		if (Item->GetEquipSound() && IsLocallyControlled())
 		{
 			UGameplayStatics::PlaySound2D(this, Item->GetEquipSound());
 		}
 	}
+
+	auto Ammo = Cast<AAmmo>(Item);
+	if (Ammo) {
+		PickupAmmo(Ammo);
+	}
+}
+
+void AShooterCharacter::PickupAmmo(AAmmo* Ammo)
+{
+	const EAmmoType AmmoType{ Ammo->GetAmmoType() };
+	int32& CarriedAmmo = AmmoMap.FindOrAdd(AmmoType);
+	CarriedAmmo += Ammo->GetItemCount();
+	CarriedAmmoChangedEvent.Broadcast(AmmoType, CarriedAmmo);
+
+	// An empty weapon of that type reloads straight away
+	if (EquipedWeapon && EquipedWeapon->GetAmmoType() == AmmoType && EquipedWeapon->GetAmmo() == 0)
+	{
+		ReloadWeapon();
+	}
+
+	if (Ammo->GetEquipSound() && IsLocallyControlled())
+	{
+		UGameplayStatics::PlaySound2D(this, Ammo->GetEquipSound());
+	}
+
+	UItemPoolSubsystem::DespawnItem(Ammo);
 }
 
@@ -5,6 +5,11 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "AmmoType.h"
+#include "WorldCollision.h"
+#include "FireScheduler.h"
+#include "CachedSocket.h"
+#include "SignificanceSubsystem.h"
+#include "Engine/StreamableManager.h"
 #include "ShooterCharacter.generated.h"
 
 UENUM(BlueprintType)
@@ -17,6 +22,139 @@ enum class ECombatState : uint8
 	EAT_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
+/* Parts of Tick that go dormant once they settle, and only run again after their inputs change */
+enum class ECharacterTickWork : uint8
+{
+	None = 0,
+	CameraZoom = 1 << 0,
+	CrosshairSpread = 1 << 1,
+	ItemTrace = 1 << 2,
+
+	All = CameraZoom | CrosshairSpread | ItemTrace
+};
+ENUM_CLASS_FLAGS(ECharacterTickWork);
+
+class AWeapon;
+class AItem;
+class UItemDefinition;
+
+/* Broadcast when the character equips a weapon, null when it is left without one */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnEquipedWeaponChanged, AWeapon* /* Weapon */);
+
+/* Broadcast when the ammo the character carries for a type changes */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnCarriedAmmoChanged, EAmmoType /* AmmoType */, int32 /* Count */);
+
+/* Where a shot leaves the barrel and the crosshair segment it is aimed along */
+struct FShotAim
+{
+	/* Barrel socket transform */
+	FTransform SocketTransform;
+
+	/* Crosshair trace segment */
+	FVector CrosshairStart{ FVector::ZeroVector };
+	FVector CrosshairEnd{ FVector::ZeroVector };
+
+	/* True for this frame's crosshair, which can use the cached crosshair trace */
+	bool bCurrentFrame = false;
+
+	/* Server time the shot was fired at, see AShooterCharacter::GetShotServerTime */
+	double ShotTime = 0.0;
+
+	/* Aim Alpha of the way from A to B, used for shots due between two ticks */
+	static FShotAim Interpolate(const FShotAim& A, const FShotAim& B, float Alpha)
+	{
+		if (Alpha >= 1.f) return B;
+
+		FShotAim Result;
+		Result.SocketTransform.Blend(A.SocketTransform, B.SocketTransform, Alpha);
+		Result.CrosshairStart = FMath::Lerp(A.CrosshairStart, B.CrosshairStart, Alpha);
+		Result.CrosshairEnd = FMath::Lerp(A.CrosshairEnd, B.CrosshairEnd, Alpha);
+		Result.ShotTime = FMath::Lerp(A.ShotTime, B.ShotTime, static_cast<double>(Alpha));
+		return Result;
+	}
+};
+
+/* Most pellets a single shot fires, matches the clamp on AWeapon::PelletCount */
+static constexpr int32 MaxPelletsPerShot = 16;
+
+/* Barrel trace end for each pellet of a shot */
+using FPelletTraceEnds = TArray<FVector, TInlineAllocator<MaxPelletsPerShot>>;
+
+/* Barrel trace result for each pellet of a shot */
+using FPelletHits = TArray<FHitResult, TInlineAllocator<MaxPelletsPerShot>>;
+
+/* Pellets of the equipped weapon at the moment a shot was fired */
+struct FPelletPattern
+{
+	int32 PelletCount = 1;
+
+	/* Half angle of the pellet cone, radians */
+	float ConeHalfAngle = 0.f;
+
+	/* Damage dealt by each pellet that hits */
+	float PelletDamage = 0.f;
+
+	/* Barrel trace end for every pellet, spread over the cone around Start -> Target */
+	void GetTraceEnds(const FVector& Start, const FVector& Target, FPelletTraceEnds& OutTraceEnds) const
+	{
+		// Trace a bit past the target so the barrel trace doesn't stop just short of it
+		const FVector StartToEnd{ (Target - Start) * 1.25f };
+
+		OutTraceEnds.Reset();
+		if (PelletCount <= 1 || ConeHalfAngle <= 0.f)
+		{
+			OutTraceEnds.Init(Start + StartToEnd, FMath::Max(PelletCount, 1));
+			return;
+		}
+
+		const float TraceLength = StartToEnd.Size();
+		const FVector Direction{ StartToEnd.GetSafeNormal() };
+		for (int32 Pellet = 0; Pellet < PelletCount; ++Pellet)
+		{
+			OutTraceEnds.Add(Start + FMath::VRandCone(Direction, ConeHalfAngle) * TraceLength);
+		}
+	}
+};
+
+/* A hitscan shot waiting on its async traces to resolve */
+struct FHitscanShot
+{
+	/* Barrel socket transform at the moment the shot was fired */
+	FTransform SocketTransform;
+
+	/* Tentative beam end, refined as each trace resolves */
+	FVector BeamEnd;
+
+	/* Pellets to trace once the crosshair trace resolves */
+	FPelletPattern Pellets;
+
+	/* Pending crosshair trace. Invalid once it has been resolved */
+	FTraceHandle CrosshairTraceHandle;
+
+	/* Pending traces from the gun barrel, one per pellet. Issued together after the crosshair trace resolves */
+	TArray<FTraceHandle, TInlineAllocator<MaxPelletsPerShot>> PelletTraceHandles;
+};
+
+/* Crosshair deprojection and trace shared by every query made in the same frame */
+struct FCrosshairTraceCache
+{
+	/* GFrameCounter the cache was filled on */
+	uint64 FrameNumber = 0;
+
+	/* Camera view the cache was filled from */
+	FVector CameraLocation{ FVector::ZeroVector };
+	FRotator CameraRotation{ FRotator::ZeroRotator };
+
+	/* True when the viewport center deprojected into TraceStart/TraceEnd */
+	bool bHasSegment = false;
+	FVector TraceStart{ FVector::ZeroVector };
+	FVector TraceEnd{ FVector::ZeroVector };
+
+	/* True once HitResult holds the trace along TraceStart/TraceEnd */
+	bool bTraced = false;
+	FHitResult HitResult;
+};
+
 UCLASS()
 class ULTIMATESHOOTER_API AShooterCharacter : public ACharacter
 {
@@ -30,6 +168,26 @@ protected:
 	/* Called when the game starts or when spawned */
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Resolves the cached hand sockets once the mesh is set up */
+	virtual void PostInitializeComponents() override;
+
+	/* Becoming or stopping being a local player's pawn changes significance right away */
+	virtual void NotifyControllerChanged() override;
+
+	/* Called by USignificanceSubsystem when the character changes tier */
+	void SetSignificance(ESignificance NewSignificance);
+
+	/* Landing and taking off change the crosshair spread */
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+
+	/* Have Tick run Work again until it settles */
+	FORCEINLINE void WakeTickWork(ECharacterTickWork Work) { ActiveTickWork |= Work; }
+
+	/* Wake the work whose polled inputs changed since it last ran: planar speed for the spread, camera and item grid for the item trace */
+	void PollTickWorkInputs();
+
 	/* Called for forwards/backwards input */
 	void MoveForward(float Value);
 
@@ -63,18 +221,74 @@ protected:
 	/** Called when a fire button is presed */
 	void FireWeapon();
 
-	bool GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation);
+	/* Point under the crosshair the shot is aimed at, the far end of the crosshair trace on a miss */
+	void GetCrosshairTarget(const FShotAim& Aim, FVector& OutTarget);
+
+	/* Pellet count, cone and damage of the equipped weapon, the cone scaled by the crosshair spread */
+	FPelletPattern GetPelletPattern() const;
+
+	/**
+	* Trace every pellet of a shot from the barrel this frame
+	* @param RewindTime  Set on the server for a remote client's shot, every other character is rewound to it
+	*/
+	void TracePellets(const FShotAim& Aim, const TOptional<double>& RewindTime = TOptional<double>());
+
+	/* Spawn effects and apply damage once per actor hit by a shot's pellets */
+	void ApplyPelletHits(const FTransform& SocketTransform, TArrayView<const FHitResult> PelletHits, float PelletDamage);
+
+	/* Server world time as this machine sees it, sent along with a client's shots */
+	double GetShotServerTime() const;
+
+	/**
+	* Have the server resolve a shot this client fired. Hitscan shots trace against characters rewound to where the client saw them,
+	* projectile shots launch the server's own projectiles. Shots without rounds in the server's magazine, from too far off the
+	* server's barrel, faster than the fire rate or from the future are dropped
+	* @param ShotTime  GetShotServerTime on the client when the shot was fired
+	*/
+	UFUNCTION(Server, Reliable)
+	void ServerSendBullet(FVector_NetQuantize BarrelLocation, FVector_NetQuantize CrosshairStart, FVector_NetQuantize CrosshairEnd, double ShotTime);
+
+	/* Start the same reload on the server, which keeps its own magazine and carried ammo to check shots against */
+	UFUNCTION(Server, Reliable)
+	void ServerReloadWeapon();
+
+	/**
+	* Pick up the server's copy of the item this client started picking up. Items aren't replicated, so the server looks for a
+	* pickup of the same class and definition that the character can reach, the one closest to ItemLocation
+	*/
+	UFUNCTION(Server, Reliable)
+	void ServerPickupItem(TSubclassOf<AItem> ItemClass, const UItemDefinition* Definition, FVector_NetQuantize ItemLocation);
+
+	/* Queue async crosshair trace for a shot, resolved in ProcessHitscanShots */
+	void QueueHitscanShot(const FShotAim& Aim);
+
+	/* Issue the async barrel traces of every pellet towards Shot.BeamEnd */
+	void QueuePelletTraces(FHitscanShot& Shot);
+
+	/* Advance queued shots whose async traces finished last frame */
+	void ProcessHitscanShots();
+
+	/* Launch a simulated projectile towards the crosshair for projectile weapons */
+	void FireProjectile(const FShotAim& Aim);
+
+	/* Spawn impact particles and the smoke beam for a shot that hit something */
+	void SpawnBulletEffects(const FTransform& SocketTransform, const FVector& BeamEnd);
 
 	void AimingButtonPressed();
 
 	void AimingButtonReleased();
 
-	void CameraInterpZoom(float DeltaTime);
+	/* Interpolate the camera FOV towards the aiming or default FOV, false once it got there */
+	bool CameraInterpZoom(float DeltaTime);
 
 	// Set BaseTurnRate and BaseLookUpRate based in aiming
 	void SetLookRates();
 
-	void CalculateCrosshairSpread(float DeltaTime);
+	/* Interpolate the crosshair spread factors, false once every one of them reached its target */
+	bool CalculateCrosshairSpread(float DeltaTime);
+
+	/* Hand CrosshairSpreadMultiplier to the owning player's AShooterHUD */
+	void PushCrosshairSpread();
 
 	void StartCrosshairBulletFire();
 
@@ -85,17 +299,36 @@ protected:
 
 	void FireButtonReleased();
 
+	/* Start the cooldown after a shot fired from FireWeapon */
 	void StartFireTimer();
-	
-	UFUNCTION()
-	void AutoFireReset();
+
+	/* Fire every automatic shot that became due this tick, ends the cooldown once the trigger is released */
+	void UpdateAutomaticFire(float DeltaTime);
+
+	/* Reset CrosshairTraceCache when the frame or the camera view changed */
+	void RefreshCrosshairTraceCache();
+
+	/* Deproject the center of the viewport into a trace segment */
+	bool GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd);
 
 	/* Line trace for items under the crosshair */
 	bool TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation);
 
-	/* Trace for items if OverlappedItemCount more than zero */
+	/* Trace for items if the item grid has an item in range */
 	void TraceForItems();
 
+	/* Start streaming in the assets of items the character is getting close to */
+	void PrefetchItemAssets();
+
+	/* Run PrefetchItemAssets on a timer while a local player or bot controls the character, outside dedicated servers */
+	void UpdateItemAssetPrefetch();
+
+	/* Called once the combat sounds, effects and montages have streamed in */
+	void OnCombatAssetsLoaded();
+
+	/* Show the shared pickup widget over Item, hide it for null */
+	void SetPickupWidgetItem(AItem* Item);
+
 	/* Spawns default weapon and quipes it */
 	class AWeapon* SpawnDefaultWeapon();
 
@@ -118,9 +351,12 @@ protected:
 	/* Check to make sure that our weapon has ammo */
 	bool WeaponHasAmmo();
 
+	/* Current barrel transform and crosshair, false if the weapon has no barrel socket */
+	bool GetShotAim(FShotAim& OutAim);
+
 	/* Fire button options */
 	void PlayFireSound();
-	void SendBullet();
+	void SendBullet(const FShotAim& Aim);
 	void PlayGunfireMontage();
 
 	/* Bound to R key and Gamepad Face Button Left*/
@@ -135,6 +371,9 @@ protected:
 	/* Checks to see if we have ammo fo the EquipedWeapons ammo type */
 	bool CarryingAmmo();
 
+	/* Add the box's rounds to AmmoMap and return it to the item pool */
+	void PickupAmmo(class AAmmo* Ammo);
+
 	/* Called from Animation Blueprint with Grab Clip notify */
 	UFUNCTION(BlueprintCallable)
 	void GrabClip();
@@ -159,25 +398,57 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 
+	/* Popup over the item the player is looking at, shared by all items. Widget class is set in Blueprint */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
+	class UWidgetComponent* PickupWidget;
+
 	/** Randomized gunshot sound cue */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	class USoundCue* FireSound;
+	TSoftObjectPtr<class USoundCue> FireSound;
 
 	/* Flash spawned at BarrelSocket */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	class UParticleSystem* MuzzleFlash;
+	TSoftObjectPtr<class UParticleSystem> MuzzleFlash;
 
 	/* Montage for firing the weapon */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	class UAnimMontage* HipFireMontage;
+	TSoftObjectPtr<class UAnimMontage> HipFireMontage;
 
 	/* Particles spawned upon bullet impact */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	UParticleSystem* ImpactParticles;
+	TSoftObjectPtr<UParticleSystem> ImpactParticles;
 
 	/* Smoke trail for bullets */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	UParticleSystem* BeamParticles;
+	TSoftObjectPtr<UParticleSystem> BeamParticles;
+
+	/* Pooled components created up front for each of the effects above */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	int32 EffectPoolPrewarmCount;
+
+	/* Copies of DefaultWeaponClass kept parked in the item pool, so the next character's default weapon doesn't spawn an actor */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	int32 DefaultWeaponPrewarmCount;
+
+	/* Keeps the combat sounds, effects and montages loaded, see UAssetStreamingSubsystem */
+	TSharedPtr<FStreamableHandle> CombatAssetsHandle;
+
+	/* Looks for items whose assets should start streaming in */
+	FTimerHandle ItemAssetPrefetchTimer;
+
+	/* Tier the significance subsystem last put the character in */
+	ESignificance Significance;
+
+	/* Parts of Tick that haven't settled yet */
+	ECharacterTickWork ActiveTickWork;
+
+	/* Planar speed the crosshair spread was last calculated for */
+	float SpreadSpeed;
+
+	/* Camera view and item grid revision the item trace last ran for */
+	FVector ItemTraceCameraLocation;
+	FQuat ItemTraceCameraRotation;
+	uint32 ItemTraceGridRevision;
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -271,19 +542,35 @@ private:
 	/* Rate of automatic gunfire */
 	float AutomaticFireRate;
 
-	/* Sets a timer between gunshots */
-	FTimerHandle AutoFireTimer;
+	/* Counts down between gunshots and tells how many automatic shots are due each tick */
+	FFireScheduler FireScheduler;
+
+	/* Aim at the end of the previous tick while the fire timer runs, automatic shots interpolate from it to this tick's aim */
+	FShotAim PreviousTickAim;
+
+	/* False when the previous tick had no aim to record, shots then leave from this tick's aim */
+	bool bHasPreviousTickAim;
+
+	/* Frame FireWeapon last fired on, the scheduler starts counting from the next tick */
+	uint64 FireWeaponFrame;
+
+	/* Shots waiting on async traces when Shooter.AsyncHitscan is enabled */
+	TArray<FHitscanShot> PendingHitscanShots;
+
+	/* Crosshair trace for this frame, see TraceUnderCrosshairs */
+	FCrosshairTraceCache CrosshairTraceCache;
 
 	/* True if we should trace every frame for items */
 	bool bShouldTraceForItems;
 
-	/* Number of overlaped AItems */
-	int8 OverlappedItemCount;
-
 	/* The AItem we hit last frame */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "True"))
 	class AItem* TraceHitItemLastFrame;
 
+	/* The AItem PickupWidget is showing */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "True"))
+	AItem* PickupWidgetItem;
+
 	/* Currently equiped weapon */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "True"))
 	AWeapon* EquipedWeapon;
@@ -316,6 +603,10 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Items, meta = (AllowPrivateAccess = "True"))
 	int32 StartingARAmmo;
 
+	/* Starting ammount of shotgun shells */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Items, meta = (AllowPrivateAccess = "True"))
+	int32 StartingShellsAmmo;
+
 
 	/* Combat state, can only fire or reload if Unoccupied */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "True"))
@@ -323,7 +614,7 @@ private:
 
 	/* Montage for reload animation */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
-	UAnimMontage* ReloadMontage;
+	TSoftObjectPtr<UAnimMontage> ReloadMontage;
 
 	/* Transform of the clip when we firs grab the clip during reloading */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "True"))
@@ -335,6 +626,15 @@ private:
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "True"))
 	bool bCrouching;
+
+	/* Socket the equiped weapon is attached to */
+	FCachedSocket RightHandSocket;
+
+	/* Bone the clip is held by during reloading */
+	FCachedSocket LeftHandBone;
+
+	FOnEquipedWeaponChanged EquipedWeaponChangedEvent;
+	FOnCarriedAmmoChanged CarriedAmmoChangedEvent;
 public:
 	/** Returns CameraBoom subobject */
 	FORCEINLINE USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
@@ -347,15 +647,21 @@ public:
 	UFUNCTION(BlueprintCallable)
 	float GetCrosshairSpreadMultiplier() const;
 
-	FORCEINLINE int8 GetOverlappedItemCount() const { return OverlappedItemCount; }
-
-	/* Adds/subtracts to/from overlapped item count and updates the bShouldTraceForItems */
-	void IncrementOverlappedItemCount(int8 Amount);
-
 	FVector GetCameraInterpLocation();
 
 	void GetPickupItem(AItem* Item);
 
 	FORCEINLINE ECombatState GetCombatState() const { return CombatState; }
 	FORCEINLINE bool GetCrounching() const { return bCrouching; }
+
+	FORCEINLINE AWeapon* GetEquipedWeapon() const { return EquipedWeapon; }
+
+	/* Ammo of AmmoType carried outside the equiped weapon's magazine */
+	int32 GetCarriedAmmo(EAmmoType AmmoType) const;
+
+	/* Fired by EquipWeapon and SwapWeapon */
+	FORCEINLINE FOnEquipedWeaponChanged& OnEquipedWeaponChanged() { return EquipedWeaponChangedEvent; }
+
+	/* Fired when reloading or picking up ammo changes AmmoMap */
+	FORCEINLINE FOnCarriedAmmoChanged& OnCarriedAmmoChanged() { return CarriedAmmoChangedEvent; }
 };
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterDiagnosticsSubsystem.h"
+#include "UltimateShooter.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_SHOOTER_DIAGNOSTICS
+
+static TAutoConsoleVariable<bool> CVarDebugTurnInPlace(
+	TEXT("Shooter.Debug.TurnInPlace"),
+	false,
+	TEXT("Show the turn in place root yaw offset of characters standing still on screen."));
+
+static TAutoConsoleVariable<bool> CVarDebugCrosshairSpread(
+	TEXT("Shooter.Debug.CrosshairSpread"),
+	false,
+	TEXT("Show the local player's crosshair spread factors on screen."));
+
+static TAutoConsoleVariable<bool> CVarDebugTraces(
+	TEXT("Shooter.Debug.Traces"),
+	false,
+	TEXT("Draw crosshair traces and hitscan shots."));
+
+static TAutoConsoleVariable<bool> CVarDebugItemState(
+	TEXT("Shooter.Debug.ItemState"),
+	false,
+	TEXT("Draw the new state over items when they change state."));
+
+static TAutoConsoleVariable<bool> CVarDebugSignificance(
+	TEXT("Shooter.Debug.Significance"),
+	false,
+	TEXT("Show the number of actors in each significance tier on screen."));
+
+static FAutoConsoleVariableSink DiagnosticsCVarSink(FConsoleCommandDelegate::CreateStatic(&UShooterDiagnosticsSubsystem::RefreshEnabledCategories));
+
+#endif
+
+/* Keys of AddMessage's screen messages, clear of the small keys used elsewhere */
+static constexpr uint64 DiagnosticsMessageKeyBase = 0x5348'4447'0000'0000;
+
+uint32 UShooterDiagnosticsSubsystem::EnabledCategories = 0;
+
+bool UShooterDiagnosticsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	return Super::ShouldCreateSubsystem(Outer);
+#else
+	return false;
+#endif
+}
+
+bool UShooterDiagnosticsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterDiagnosticsSubsystem::RefreshEnabledCategories()
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	uint32 NewEnabledCategories = 0;
+	auto Enable = [&NewEnabledCategories](EShooterDebugCategory Category, const TAutoConsoleVariable<bool>& CVar)
+	{
+		if (CVar.GetValueOnGameThread())
+		{
+			NewEnabledCategories |= 1u << static_cast<uint32>(Category);
+		}
+	};
+	Enable(EShooterDebugCategory::TurnInPlace, CVarDebugTurnInPlace);
+	Enable(EShooterDebugCategory::CrosshairSpread, CVarDebugCrosshairSpread);
+	Enable(EShooterDebugCategory::Traces, CVarDebugTraces);
+	Enable(EShooterDebugCategory::ItemState, CVarDebugItemState);
+	Enable(EShooterDebugCategory::Significance, CVarDebugSignificance);
+	EnabledCategories = NewEnabledCategories;
+#endif
+}
+
+void UShooterDiagnosticsSubsystem::AddMessage(EShooterDebugCategory Category, const FString& Message, const FColor& Color, int32 Slot)
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (GEngine == nullptr) return;
+
+	const uint64 Key = DiagnosticsMessageKeyBase + (static_cast<uint64>(Category) << 16) + static_cast<uint16>(Slot);
+	GEngine->AddOnScreenDebugMessage(Key, 0.f, Color, Message);
+#endif
+}
+
+void UShooterDiagnosticsSubsystem::DrawLine(const UObject* WorldContextObject, const FVector& Start, const FVector& End, const FColor& Color, float Duration)
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (const UShooterDiagnosticsSubsystem* Diagnostics = Get(WorldContextObject))
+	{
+		DrawDebugLine(Diagnostics->GetWorld(), Start, End, Color, false, Duration);
+	}
+#endif
+}
+
+void UShooterDiagnosticsSubsystem::DrawPoint(const UObject* WorldContextObject, const FVector& Location, const FColor& Color, float Duration)
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (const UShooterDiagnosticsSubsystem* Diagnostics = Get(WorldContextObject))
+	{
+		DrawDebugPoint(Diagnostics->GetWorld(), Location, 8.f, Color, false, Duration);
+	}
+#endif
+}
+
+void UShooterDiagnosticsSubsystem::DrawString(const UObject* WorldContextObject, const FVector& Location, const FString& Text, const FColor& Color, float Duration)
+{
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (const UShooterDiagnosticsSubsystem* Diagnostics = Get(WorldContextObject))
+	{
+		DrawDebugString(Diagnostics->GetWorld(), Location, Text, nullptr, Color, Duration);
+	}
+#endif
+}
+
+UShooterDiagnosticsSubsystem* UShooterDiagnosticsSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UShooterDiagnosticsSubsystem>() : nullptr;
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterDiagnosticsSubsystem.generated.h"
+
+/* Debug drawing and screen messages, compiled out of Shipping. Wrap call sites in #if WITH_SHOOTER_DIAGNOSTICS */
+#define WITH_SHOOTER_DIAGNOSTICS (!UE_BUILD_SHIPPING)
+
+/* Diagnostics that are switched on one at a time, each by a Shooter.Debug.<Category> console variable */
+enum class EShooterDebugCategory : uint8
+{
+	TurnInPlace,
+	CrosshairSpread,
+	Traces,
+	ItemState,
+	Significance,
+
+	MAX
+};
+
+/**
+ * Single way out for debug output. Call sites test IsEnabled for their category, which is one load and a branch
+ * while the category is off, and only then build the message or shape and hand it to the static helpers.
+ * The subsystem isn't created in Shipping, where the helpers do nothing
+ */
+UCLASS()
+class ULTIMATESHOOTER_API UShooterDiagnosticsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/* True if Category's console variable is on */
+	static FORCEINLINE bool IsEnabled(EShooterDebugCategory Category) { return (EnabledCategories & (1u << static_cast<uint32>(Category))) != 0; }
+
+	/* Recompute the enabled categories, called whenever console variables change */
+	static void RefreshEnabledCategories();
+
+	/**
+	* Show Message on screen for one frame, replacing the previous message with the same Category and Slot
+	* @param Slot  Tells apart several messages of one category shown at the same time
+	*/
+	static void AddMessage(EShooterDebugCategory Category, const FString& Message, const FColor& Color = FColor::Green, int32 Slot = 0);
+
+	/* Draw a line in WorldContextObject's world, for one frame unless Duration is set */
+	static void DrawLine(const UObject* WorldContextObject, const FVector& Start, const FVector& End, const FColor& Color, float Duration = 0.f);
+
+	/* Draw a point in WorldContextObject's world */
+	static void DrawPoint(const UObject* WorldContextObject, const FVector& Location, const FColor& Color, float Duration = 0.f);
+
+	/* Draw Text at Location in WorldContextObject's world */
+	static void DrawString(const UObject* WorldContextObject, const FVector& Location, const FString& Text, const FColor& Color, float Duration = 0.f);
+
+private:
+	/* The world's diagnostics subsystem, null in Shipping */
+	static UShooterDiagnosticsSubsystem* Get(const UObject* WorldContextObject);
+
+	/* Bit per EShooterDebugCategory */
+	static uint32 EnabledCategories;
+};
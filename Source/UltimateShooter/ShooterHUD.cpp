@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterHUD.h"
+#include "UltimateShooter.h"
+#include "ShooterCharacter.h"
+#include "ShooterPlayerController.h"
+#include "Components/Widget.h"
+#include "Engine/Canvas.h"
+#include "Engine/Texture2D.h"
+
+static TAutoConsoleVariable<bool> CVarHUDShowCrosshair(
+	TEXT("Shooter.HUD.ShowCrosshair"),
+	true,
+	TEXT("Draw the native crosshair."));
+
+DECLARE_CYCLE_STAT(TEXT("Draw Crosshair"), STAT_DrawCrosshair, STATGROUP_UltimateShooter);
+
+AShooterHUD::AShooterHUD() :
+	CrosshairMiddle(nullptr),
+	CrosshairLeft(nullptr),
+	CrosshairRight(nullptr),
+	CrosshairTop(nullptr),
+	CrosshairBottom(nullptr),
+	CrosshairSpreadMax(16.f),
+	CrosshairColor(FLinearColor::White),
+	CrosshairSpread(0.f),
+	bHasCrosshairSpread(false),
+	bBlueprintDrawsHUD(false),
+	bOverlayCrosshairCollapsed(false)
+{
+}
+
+void AShooterHUD::BeginPlay()
+{
+	Super::BeginPlay();
+
+	bBlueprintDrawsHUD = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AHUD, ReceiveDrawHUD));
+	if (bBlueprintDrawsHUD && CrosshairMiddle)
+	{
+		UE_LOG(LogUltimateShooter, Warning, TEXT("%s draws in ReceiveDrawHUD, the native crosshair stays off until that is removed"), *GetClass()->GetName());
+	}
+}
+
+bool AShooterHUD::ShouldDrawCrosshair() const
+{
+	return CrosshairMiddle && !bBlueprintDrawsHUD && CVarHUDShowCrosshair.GetValueOnGameThread();
+}
+
+void AShooterHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	if (Canvas == nullptr || !ShouldDrawCrosshair()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_DrawCrosshair);
+
+	// Overlays made before the native crosshair still carry crosshair images, one crosshair is enough
+	if (!bOverlayCrosshairCollapsed)
+	{
+		AShooterPlayerController* ShooterController = Cast<AShooterPlayerController>(PlayerOwner);
+		bOverlayCrosshairCollapsed = ShooterController == nullptr || ShooterController->CollapseOverlayWidgets([](const UWidget* Widget)
+		{
+			return Widget->GetName().StartsWith(TEXT("Crosshair"));
+		});
+	}
+
+	if (!bHasCrosshairSpread)
+	{
+		if (const AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(GetOwningPawn()))
+		{
+			SetCrosshairSpread(ShooterCharacter->GetCrosshairSpreadMultiplier());
+		}
+	}
+
+	// Same screen point the character deprojects for its crosshair trace
+	const FVector2D Center{ Canvas->ClipX / 2.f, Canvas->ClipY / 2.f };
+	const float SpreadOffset = CrosshairSpreadMax * CrosshairSpread;
+
+	DrawCrosshairPart(CrosshairMiddle, Center, FVector2D::ZeroVector);
+	DrawCrosshairPart(CrosshairLeft, Center, FVector2D(-SpreadOffset, 0.f));
+	DrawCrosshairPart(CrosshairRight, Center, FVector2D(SpreadOffset, 0.f));
+	DrawCrosshairPart(CrosshairTop, Center, FVector2D(0.f, -SpreadOffset));
+	DrawCrosshairPart(CrosshairBottom, Center, FVector2D(0.f, SpreadOffset));
+}
+
+void AShooterHUD::DrawCrosshairPart(UTexture2D* Texture, const FVector2D& Center, const FVector2D& Offset)
+{
+	if (Texture == nullptr) return;
+
+	const float Width = Texture->GetSizeX();
+	const float Height = Texture->GetSizeY();
+	DrawTexture(
+		Texture,
+		Center.X + Offset.X - Width / 2.f,
+		Center.Y + Offset.Y - Height / 2.f,
+		Width,
+		Height,
+		0.f,
+		0.f,
+		1.f,
+		1.f,
+		CrosshairColor);
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "ShooterHUD.generated.h"
+
+class UTexture2D;
+
+/**
+ * Draws the crosshair straight onto the canvas. The owning character pushes the spread whenever it
+ * recalculates it, so drawing reads a cached float instead of polling the character through bindings.
+ * Stays out of the way of Blueprint crosshairs until it has textures to draw, see ShouldDrawCrosshair
+ */
+UCLASS()
+class ULTIMATESHOOTER_API AShooterHUD : public AHUD
+{
+	GENERATED_BODY()
+
+public:
+	AShooterHUD();
+
+	virtual void BeginPlay() override;
+	virtual void DrawHUD() override;
+
+	/* Called by AShooterCharacter when the crosshair spread multiplier changes */
+	FORCEINLINE void SetCrosshairSpread(float Spread) { CrosshairSpread = Spread; bHasCrosshairSpread = true; }
+
+private:
+	/* True if the native crosshair is switched on, has textures and the Blueprint doesn't draw a HUD of its own */
+	bool ShouldDrawCrosshair() const;
+
+	/* Draw Texture centered on Center, moved by Offset */
+	void DrawCrosshairPart(UTexture2D* Texture, const FVector2D& Center, const FVector2D& Offset);
+
+	/* Crosshair pieces, the outer four move outwards with the spread */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairMiddle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairLeft;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairRight;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairTop;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	UTexture2D* CrosshairBottom;
+
+	/* Distance in pixels the outer pieces move per unit of spread */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	float CrosshairSpreadMax;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshairs, meta = (AllowPrivateAccess = "true"))
+	FLinearColor CrosshairColor;
+
+	/* Last spread multiplier the character pushed */
+	float CrosshairSpread;
+
+	/* False until the first push. The HUD can be created after the character last pushed, it reads the spread once then */
+	bool bHasCrosshairSpread;
+
+	/* True if a Blueprint subclass implements ReceiveDrawHUD, which is where the old crosshair was drawn */
+	bool bBlueprintDrawsHUD;
+
+	/* True once the overlay's own crosshair widgets have been collapsed in favour of the native crosshair */
+	bool bOverlayCrosshairCollapsed;
+};
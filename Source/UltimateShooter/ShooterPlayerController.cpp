@@ -2,9 +2,13 @@
 
 
 #include "ShooterPlayerController.h"
+#include "UltimateShooter.h"
+#include "AmmoCountWidget.h"
 #include "Blueprint/UserWidget.h"
+#include "Blueprint/WidgetTree.h"
 
-AShooterPlayerController::AShooterPlayerController()
+AShooterPlayerController::AShooterPlayerController() :
+	AmmoCountClass(UAmmoCountWidget::StaticClass())
 {
 }
 
@@ -18,7 +22,44 @@ void AShooterPlayerController::BeginPlay()
 		HUDOverlay = CreateWidget<UUserWidget>(this, HUDOverlayClass);
 		if (HUDOverlay) {
 			HUDOverlay->AddToViewport();
-			HUDOverlay->SetVisibility(ESlateVisibility::Visible);
+			// Nothing on the overlay takes input, keep it out of the hit test grid
+			HUDOverlay->SetVisibility(ESlateVisibility::SelfHitTestInvisible);
 		}
 	}
+
+	// Overlays made before UAmmoCountWidget hold an ammo count that reads properties weapons no longer have.
+	// Until the overlay is migrated, collapse that one and show the native one instead
+	bool bOverlayHasAmmoCount = false;
+	const bool bHasOverlay = CollapseOverlayWidgets([&bOverlayHasAmmoCount](const UWidget* Widget)
+	{
+		bOverlayHasAmmoCount |= Widget->IsA<UAmmoCountWidget>();
+		return !Widget->IsA<UAmmoCountWidget>() && Widget->GetClass()->GetName().StartsWith(TEXT("AmmoCount"));
+	});
+	if (bHasOverlay && !bOverlayHasAmmoCount && AmmoCountClass)
+	{
+		UE_LOG(LogUltimateShooter, Log, TEXT("%s has no UAmmoCountWidget, showing %s next to it"), *HUDOverlay->GetClass()->GetName(), *AmmoCountClass->GetName());
+		AmmoCount = CreateWidget<UAmmoCountWidget>(this, AmmoCountClass);
+		if (AmmoCount)
+		{
+			AmmoCount->SetAnchorsInViewport(FAnchors(1.f, 1.f));
+			AmmoCount->SetAlignmentInViewport(FVector2D(1.f, 1.f));
+			AmmoCount->SetPositionInViewport(FVector2D(-48.f, -48.f), false);
+			AmmoCount->AddToViewport();
+			AmmoCount->SetVisibility(ESlateVisibility::SelfHitTestInvisible);
+		}
+	}
+}
+
+bool AShooterPlayerController::CollapseOverlayWidgets(TFunctionRef<bool(const UWidget*)> Predicate)
+{
+	if (HUDOverlay == nullptr || HUDOverlay->WidgetTree == nullptr) return false;
+
+	HUDOverlay->WidgetTree->ForEachWidget([&Predicate](UWidget* Widget)
+	{
+		if (Predicate(Widget))
+		{
+			Widget->SetVisibility(ESlateVisibility::Collapsed);
+		}
+	});
+	return true;
 }
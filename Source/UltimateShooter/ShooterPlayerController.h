@@ -6,6 +6,9 @@
 #include "GameFramework/PlayerController.h"
 #include "ShooterPlayerController.generated.h"
 
+class UWidget;
+class UAmmoCountWidget;
+
 /**
  * 
  */
@@ -17,6 +20,9 @@ class ULTIMATESHOOTER_API AShooterPlayerController : public APlayerController
 public:
 	AShooterPlayerController();
 
+	/* Collapse every widget on the HUD overlay that Predicate picks, false if there is no overlay */
+	bool CollapseOverlayWidgets(TFunctionRef<bool(const UWidget*)> Predicate);
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -28,4 +34,11 @@ private:
 	/* Variable to hold the HUD Overlay Widget after creating it */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Widgets, meta = (AllowPrivateAccess = "true"))
 	UUserWidget* HUDOverlay;
+
+	/* Ammo count shown next to an overlay that doesn't have a UAmmoCountWidget of its own */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Widgets, meta = (AllowPrivateAccess = "true"))
+	TSubclassOf<UAmmoCountWidget> AmmoCountClass;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Widgets, meta = (AllowPrivateAccess = "true"))
+	UAmmoCountWidget* AmmoCount;
 };
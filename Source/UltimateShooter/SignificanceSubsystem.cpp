@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SignificanceSubsystem.h"
+#include "UltimateShooter.h"
+#include "ShooterDiagnosticsSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<int32> CVarSignificanceUpdatesPerFrame(
+	TEXT("Shooter.Significance.UpdatesPerFrame"),
+	128,
+	TEXT("Most actors whose significance tier is recomputed per frame, the rest wait for their turn."));
+
+static TAutoConsoleVariable<float> CVarSignificanceHighDistance(
+	TEXT("Shooter.Significance.HighDistance"),
+	1500.f,
+	TEXT("Actors closer than this to a local player's view are ES_High."));
+
+static TAutoConsoleVariable<float> CVarSignificanceMediumDistance(
+	TEXT("Shooter.Significance.MediumDistance"),
+	4000.f,
+	TEXT("Actors closer than this to a local player's view are at least ES_Medium."));
+
+static TAutoConsoleVariable<float> CVarSignificanceLowDistance(
+	TEXT("Shooter.Significance.LowDistance"),
+	8000.f,
+	TEXT("Actors closer than this to a local player's view are at least ES_Low, anything further is ES_Minimal."));
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_SignificanceUpdate, STATGROUP_UltimateShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Actors"), STAT_SignificanceActors, STATGROUP_UltimateShooter);
+
+/* Seconds between ticks in each tier, indexed by ESignificance */
+static const float SignificanceTickIntervals[] =
+{
+	/* ES_High */
+	0.f,
+	/* ES_Medium */
+	1.f / 30.f,
+	/* ES_Low */
+	1.f / 10.f,
+	/* ES_Minimal */
+	1.f / 4.f,
+};
+static_assert(UE_ARRAY_COUNT(SignificanceTickIntervals) == static_cast<SIZE_T>(ESignificance::ES_MAX), "One tick interval per ESignificance");
+
+/* How recently an actor has to have been rendered to count as visible */
+static constexpr float SignificanceRenderTolerance = 0.2f;
+
+USignificanceSubsystem::USignificanceSubsystem() :
+	TierCounts(),
+	UpdateCursor(0)
+{
+}
+
+bool USignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USignificanceSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_SignificanceActors, Entries.Num());
+	Entries.Empty();
+	EntryIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void USignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const int32 NumEntries = Entries.Num();
+	int32 NumUpdated = 0;
+	if (NumEntries > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SignificanceUpdate);
+
+		GatherViews();
+
+		// Round robin from where the last frame stopped so every actor gets its turn
+		NumUpdated = FMath::Min(CVarSignificanceUpdatesPerFrame.GetValueOnGameThread(), NumEntries);
+		for (int32 Visited = 0; Visited < NumUpdated; ++Visited)
+		{
+			UpdateEntry((UpdateCursor + Visited) % NumEntries);
+		}
+		UpdateCursor = (UpdateCursor + NumUpdated) % NumEntries;
+	}
+
+#if WITH_SHOOTER_DIAGNOSTICS
+	if (UShooterDiagnosticsSubsystem::IsEnabled(EShooterDebugCategory::Significance))
+	{
+		DrawDebugOverlay(NumUpdated);
+	}
+#endif
+}
+
+TStatId USignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void USignificanceSubsystem::RegisterActor(AActor* Actor, FOnSignificanceChanged OnSignificanceChanged)
+{
+	if (Actor == nullptr || EntryIndices.Contains(Actor)) return;
+
+	const ESignificance Significance = ComputeSignificance(Actor);
+
+	EntryIndices.Add(Actor, Entries.Num());
+	Entries.Add({ Actor, OnSignificanceChanged, Significance });
+	++TierCounts[static_cast<int32>(Significance)];
+	INC_DWORD_STAT(STAT_SignificanceActors);
+
+	OnSignificanceChanged.ExecuteIfBound(Significance);
+}
+
+void USignificanceSubsystem::UnregisterActor(AActor* Actor)
+{
+	int32 Index = INDEX_NONE;
+	if (!EntryIndices.RemoveAndCopyValue(Actor, Index)) return;
+
+	--TierCounts[static_cast<int32>(Entries[Index].Significance)];
+	DEC_DWORD_STAT(STAT_SignificanceActors);
+
+	Entries.RemoveAtSwap(Index, 1, false);
+	if (Entries.IsValidIndex(Index))
+	{
+		// The last entry took the removed one's place
+		if (int32* MovedIndex = EntryIndices.Find(Entries[Index].Actor.Get(true)))
+		{
+			*MovedIndex = Index;
+		}
+	}
+}
+
+void USignificanceSubsystem::RefreshActor(AActor* Actor)
+{
+	if (const int32* Index = EntryIndices.Find(Actor))
+	{
+		GatherViews();
+		UpdateEntry(*Index);
+	}
+}
+
+float USignificanceSubsystem::GetTickInterval(ESignificance Significance)
+{
+	const int32 TierIndex = static_cast<int32>(Significance);
+	return TierIndex < static_cast<int32>(UE_ARRAY_COUNT(SignificanceTickIntervals)) ? SignificanceTickIntervals[TierIndex] : 0.f;
+}
+
+void USignificanceSubsystem::GatherViews()
+{
+	ViewLocations.Reset();
+	ViewActors.Reset();
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController == nullptr || !PlayerController->IsLocalController()) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		ViewLocations.Add(ViewLocation);
+
+		ViewActors.Add(PlayerController->GetPawn());
+		ViewActors.Add(PlayerController->GetViewTarget());
+	}
+}
+
+ESignificance USignificanceSubsystem::ComputeSignificance(const AActor* Actor) const
+{
+	// Nobody is watching on a dedicated server, everything keeps its full rate
+	if (ViewLocations.Num() == 0 || ViewActors.Contains(Actor)) return ESignificance::ES_High;
+
+	const FVector ActorLocation{ Actor->GetActorLocation() };
+	double MinDistanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ActorLocation, ViewLocation));
+	}
+
+	int32 TierIndex = static_cast<int32>(ESignificance::ES_Minimal);
+	if (MinDistanceSquared < FMath::Square(CVarSignificanceHighDistance.GetValueOnGameThread()))
+	{
+		TierIndex = static_cast<int32>(ESignificance::ES_High);
+	}
+	else if (MinDistanceSquared < FMath::Square(CVarSignificanceMediumDistance.GetValueOnGameThread()))
+	{
+		TierIndex = static_cast<int32>(ESignificance::ES_Medium);
+	}
+	else if (MinDistanceSquared < FMath::Square(CVarSignificanceLowDistance.GetValueOnGameThread()))
+	{
+		TierIndex = static_cast<int32>(ESignificance::ES_Low);
+	}
+
+	// Off screen actors drop a tier, except close by where they can swing into view any moment
+	if (TierIndex != static_cast<int32>(ESignificance::ES_High) && !Actor->WasRecentlyRendered(SignificanceRenderTolerance))
+	{
+		TierIndex = FMath::Min(TierIndex + 1, static_cast<int32>(ESignificance::ES_Minimal));
+	}
+	return static_cast<ESignificance>(TierIndex);
+}
+
+void USignificanceSubsystem::UpdateEntry(int32 Index)
+{
+	FSignificanceEntry& Entry = Entries[Index];
+	const AActor* Actor = Entry.Actor.Get();
+	if (Actor == nullptr) return;
+
+	const ESignificance Significance = ComputeSignificance(Actor);
+	if (Significance == Entry.Significance) return;
+
+	--TierCounts[static_cast<int32>(Entry.Significance)];
+	++TierCounts[static_cast<int32>(Significance)];
+	Entry.Significance = Significance;
+	Entry.OnSignificanceChanged.ExecuteIfBound(Significance);
+}
+
+#if WITH_SHOOTER_DIAGNOSTICS
+void USignificanceSubsystem::DrawDebugOverlay(int32 NumUpdated) const
+{
+	FString Message = FString::Printf(TEXT("Significance: %d actors, %d updated this frame"), Entries.Num(), NumUpdated);
+	for (int32 TierIndex = 0; TierIndex < static_cast<int32>(ESignificance::ES_MAX); ++TierIndex)
+	{
+		Message += FString::Printf(TEXT("\n    %-8s %d"),
+			*UEnum::GetDisplayValueAsText(static_cast<ESignificance>(TierIndex)).ToString(),
+			TierCounts[TierIndex]);
+	}
+	UShooterDiagnosticsSubsystem::AddMessage(EShooterDebugCategory::Significance, Message, FColor::Cyan);
+}
+#endif
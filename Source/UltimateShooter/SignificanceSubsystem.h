@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterDiagnosticsSubsystem.h"
+#include "SignificanceSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ESignificance : uint8
+{
+	ES_High UMETA(DisplayName = "High"),
+	ES_Medium UMETA(DisplayName = "Medium"),
+	ES_Low UMETA(DisplayName = "Low"),
+	ES_Minimal UMETA(DisplayName = "Minimal"),
+
+	ES_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+DECLARE_DELEGATE_OneParam(FOnSignificanceChanged, ESignificance);
+
+/* A registered actor and the tier it was last put in */
+struct FSignificanceEntry
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	FOnSignificanceChanged OnSignificanceChanged;
+
+	ESignificance Significance;
+};
+
+/**
+ * Buckets registered actors by distance to the local players' view, actors past the closest tier drop
+ * another tier when they weren't rendered recently. Actors are told when their tier changes and scale
+ * their own work down, tiers are recomputed round robin for a fixed number of actors per frame
+ */
+UCLASS()
+class ULTIMATESHOOTER_API USignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	USignificanceSubsystem();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Start bucketing Actor, OnSignificanceChanged is called with its tier right away */
+	void RegisterActor(AActor* Actor, FOnSignificanceChanged OnSignificanceChanged);
+
+	/* Stop bucketing Actor */
+	void UnregisterActor(AActor* Actor);
+
+	/* Recompute Actor's tier now instead of waiting for its turn, for actors that just started doing something visible */
+	void RefreshActor(AActor* Actor);
+
+	/* Tick interval actors and their animation use in a tier */
+	static float GetTickInterval(ESignificance Significance);
+
+	FORCEINLINE int32 GetNumActors() const { return Entries.Num(); }
+
+private:
+	/* Collect the view locations and pawns of local players */
+	void GatherViews();
+
+	/* Tier for Actor from the views gathered this frame */
+	ESignificance ComputeSignificance(const AActor* Actor) const;
+
+	/* Recompute Entries[Index], notifying the actor if its tier changed */
+	void UpdateEntry(int32 Index);
+
+#if WITH_SHOOTER_DIAGNOSTICS
+	/* Show tier counts on screen, see Shooter.Debug.Significance */
+	void DrawDebugOverlay(int32 NumUpdated) const;
+#endif
+
+	TArray<FSignificanceEntry> Entries;
+
+	/* Index into Entries of every registered actor */
+	TMap<const AActor*, int32> EntryIndices;
+
+	/* Number of entries in each tier */
+	int32 TierCounts[static_cast<int32>(ESignificance::ES_MAX)];
+
+	/* View locations of local players this frame */
+	TArray<FVector> ViewLocations;
+
+	/* Local players' pawns and view targets, always ES_High */
+	TArray<const AActor*> ViewActors;
+
+	/* Where Tick continues next frame */
+	int32 UpdateCursor;
+};
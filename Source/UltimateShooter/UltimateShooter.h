@@ -4,3 +4,6 @@
 
 #include "CoreMinimal.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogUltimateShooter, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("UltimateShooter"), STATGROUP_UltimateShooter, STATCAT_Advanced);
@@ -2,4 +2,10 @@
 
 
 #include "UltimateShooterGameModeBase.h"
+#include "ShooterHUD.h"
+
+AUltimateShooterGameModeBase::AUltimateShooterGameModeBase()
+{
+	HUDClass = AShooterHUD::StaticClass();
+}
 
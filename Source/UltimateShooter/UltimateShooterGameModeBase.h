@@ -13,5 +13,7 @@ UCLASS()
 class ULTIMATESHOOTER_API AUltimateShooterGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	AUltimateShooterGameModeBase();
 };
@@ -2,18 +2,30 @@
 
 
 #include "Weapon.h"
+#include "Components/AudioComponent.h"
+#include "Kismet/GameplayStatics.h"
 
 AWeapon::AWeapon():
 	ThrowWeaponTime(0.7f),
 	bFalling(false),
-	Ammo(30),
-	MagazineCapacity(30),
-	WeaponType(EWeaponType::EWT_SubmachineGun),
-	AmmoType(EAmmoType::EAT_9mm),
-	ReloadMontageSection(FName("Reload SMG")),
-	ClipBoneName("smg_clip")
+	Ammo(30)
 {
 	PrimaryActorTick.bCanEverTick = true;
+
+	FireAudioComponent = CreateDefaultSubobject<UAudioComponent>(TEXT("FireAudio"));
+	FireAudioComponent->SetupAttachment(GetRootComponent());
+	FireAudioComponent->bAutoActivate = false;
+	// Heard the same as the 2D sound played per shot
+	FireAudioComponent->bAllowSpatialization = false;
+
+#if WITH_EDITORONLY_DATA
+	// Defaults the properties had before they moved to UWeaponDefinition
+	MagazineCapacity_DEPRECATED = 30;
+	WeaponType_DEPRECATED = EWeaponType::EWT_SubmachineGun;
+	AmmoType_DEPRECATED = EAmmoType::EAT_9mm;
+	ReloadMontageSection_DEPRECATED = FName("Reload SMG");
+	ClipBoneName_DEPRECATED = FName("smg_clip");
+#endif
 }
 
 void AWeapon::Tick(float DeltaTime)
@@ -28,6 +40,94 @@ void AWeapon::Tick(float DeltaTime)
 	}
 }
 
+void AWeapon::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	ResolveSockets();
+}
+
+const UWeaponDefinition* AWeapon::GetWeaponDefinition() const
+{
+	const UWeaponDefinition* WeaponDefinition = Cast<UWeaponDefinition>(GetDefinition());
+	return WeaponDefinition ? WeaponDefinition : GetDefault<UWeaponDefinition>();
+}
+
+#if WITH_EDITOR
+const UItemDefinition* AWeapon::GetMigrationTemplate() const
+{
+	return GetWeaponDefinition();
+}
+
+bool AWeapon::MigrateDeprecatedProperties(const AItem& Archetype, UItemDefinition& Migrated) const
+{
+	bool bMigrated = Super::MigrateDeprecatedProperties(Archetype, Migrated);
+
+	const AWeapon* WeaponArchetype = Cast<AWeapon>(&Archetype);
+	UWeaponDefinition* WeaponMigrated = Cast<UWeaponDefinition>(&Migrated);
+	if (WeaponArchetype == nullptr || WeaponMigrated == nullptr) return bMigrated;
+
+	auto MigrateIfOverridden = [&bMigrated](const auto& Value, const auto& ArchetypeValue, auto& Target)
+	{
+		if (Value == ArchetypeValue) return;
+
+		Target = Value;
+		bMigrated = true;
+	};
+	MigrateIfOverridden(MagazineCapacity_DEPRECATED, WeaponArchetype->MagazineCapacity_DEPRECATED, WeaponMigrated->MagazineCapacity);
+	MigrateIfOverridden(WeaponType_DEPRECATED, WeaponArchetype->WeaponType_DEPRECATED, WeaponMigrated->WeaponType);
+	MigrateIfOverridden(AmmoType_DEPRECATED, WeaponArchetype->AmmoType_DEPRECATED, WeaponMigrated->AmmoType);
+	MigrateIfOverridden(ReloadMontageSection_DEPRECATED, WeaponArchetype->ReloadMontageSection_DEPRECATED, WeaponMigrated->ReloadMontageSection);
+	MigrateIfOverridden(ClipBoneName_DEPRECATED, WeaponArchetype->ClipBoneName_DEPRECATED, WeaponMigrated->ClipBoneName);
+	return bMigrated;
+}
+#endif
+
+void AWeapon::ResolveSockets()
+{
+	BarrelSocket = FCachedSocket(GetWeaponDefinition()->GetBarrelSocketName());
+	BarrelSocket.Resolve(GetItemMesh());
+
+	ClipBone = FCachedSocket(GetClipBoneName());
+	ClipBone.Resolve(GetItemMesh());
+}
+
+bool AWeapon::GetBarrelSocketTransform(FTransform& OutTransform)
+{
+	// Resolve again if the definition was swapped for one with other names
+	if (BarrelSocket.GetName() != GetWeaponDefinition()->GetBarrelSocketName()) ResolveSockets();
+	return BarrelSocket.GetWorldTransform(GetItemMesh(), OutTransform);
+}
+
+bool AWeapon::GetClipBoneTransform(FTransform& OutTransform)
+{
+	if (ClipBone.GetName() != GetClipBoneName()) ResolveSockets();
+	return ClipBone.GetWorldTransform(GetItemMesh(), OutTransform);
+}
+
+void AWeapon::StartFireLoop()
+{
+	USoundBase* FireLoopSound = GetWeaponDefinition()->GetFireLoopSound();
+	if (FireLoopSound == nullptr || FireAudioComponent->IsPlaying()) return;
+
+	if (FireAudioComponent->Sound != FireLoopSound)
+	{
+		FireAudioComponent->SetSound(FireLoopSound);
+	}
+	FireAudioComponent->Play();
+}
+
+void AWeapon::StopFireLoop()
+{
+	if (!FireAudioComponent->IsPlaying()) return;
+
+	FireAudioComponent->Stop();
+	if (USoundBase* FireTailSound = GetWeaponDefinition()->GetFireTailSound())
+	{
+		UGameplayStatics::PlaySound2D(this, FireTailSound);
+	}
+}
+
 void AWeapon::ThrowWeapon()
 {
 	FRotator MeshRotation{ 0.f, GetItemMesh()->GetComponentRotation().Yaw, 0.f };
@@ -44,6 +144,7 @@ void AWeapon::ThrowWeapon()
 	GetItemMesh()->AddImpulse(ImpulseDirection);
 
 	bFalling = true;
+	UpdateTickEnabled();
 
 	GetWorldTimerManager().SetTimer(ThrowWeaponTimer, this, &AWeapon::StopFalling, ThrowWeaponTime);
 }
@@ -58,21 +159,43 @@ void AWeapon::DecrementAmmo()
 	{
 		--Ammo;
 	}
+	AmmoChangedEvent.Broadcast(this);
 }
 
 void AWeapon::ReloadAmmo(int32 Amount)
 {
-	checkf(Ammo + Amount <= MagazineCapacity, TEXT("Attempted to reload with more then magazine capacity!"));
+	checkf(Ammo + Amount <= GetMagazineCapacity(), TEXT("Attempted to reload with more then magazine capacity!"));
 	Ammo += Amount;
+	AmmoChangedEvent.Broadcast(this);
 }
 
 bool AWeapon::ClipIsFull()
 {
-	return Ammo >= MagazineCapacity;
+	return Ammo >= GetMagazineCapacity();
 }
 
 void AWeapon::StopFalling()
 {
-	bFalling = true;
+	bFalling = false;
 	SetItemState(EItemState::EIS_Pickup);
+	UpdateTickEnabled();
+}
+
+void AWeapon::ResetPooledItem()
+{
+	bFalling = false;
+	bMovingClip = false;
+	Ammo = GetDefault<AWeapon>(GetClass())->Ammo;
+	AmmoChangedEvent.Broadcast(this);
+	if (FireAudioComponent->IsPlaying())
+	{
+		FireAudioComponent->Stop();
+	}
+
+	Super::ResetPooledItem();
+}
+
+bool AWeapon::NeedsTick() const
+{
+	return Super::NeedsTick() || (GetItemState() == EItemState::EIS_Falling && bFalling);
 }
@@ -4,17 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "Item.h"
-#include "AmmoType.h"
+#include "WeaponDefinition.h"
+#include "CachedSocket.h"
 #include "Weapon.generated.h"
 
-UENUM(BlueprintType)
-enum class EWeaponType : uint8
-{
-	EWT_SubmachineGun UMETA(DisplayName = "SubmachineGun"),
-	EWT_AssaultRifle UMETA(DisplayName = "AssaultRifle"),
+class AWeapon;
 
-	EWT_MAX UMETA(DisplayName = "DefaultMAX")
-};
+/* Broadcast whenever the magazine's ammo count changes */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnWeaponAmmoChanged, AWeapon* /* Weapon */);
 
 /**
  * 
@@ -28,8 +25,21 @@ public:
 	AWeapon();
 
 	virtual void Tick(float DeltaTime);
+
+	virtual void PostInitializeComponents() override;
 protected:
 	void StopFalling();
+
+	/* Also ticks while falling, to keep the weapon upright */
+	virtual bool NeedsTick() const override;
+
+	/* Resolve the cached sockets against the item mesh */
+	void ResolveSockets();
+
+#if WITH_EDITOR
+	virtual const UItemDefinition* GetMigrationTemplate() const override;
+	virtual bool MigrateDeprecatedProperties(const AItem& Archetype, UItemDefinition& Migrated) const override;
+#endif
 private:
 	FTimerHandle ThrowWeaponTimer;
 	float ThrowWeaponTime;
@@ -39,48 +49,90 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
 	int32 Ammo;
 
-	/* Maximum Ammo that our weapon can hold */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	int32 MagazineCapacity;
+	/* True while moving the clip while reloading */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	bool bMovingClip;
 
-	/* The type of weapon */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	EWeaponType WeaponType;
+	/* The definition's BarrelSocketName and ClipBoneName resolved on the item mesh */
+	FCachedSocket BarrelSocket;
+	FCachedSocket ClipBone;
 
-	/* Type of ammo for this weapon */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	EAmmoType AmmoType;
+	/* Persistent voice playing the definition's FireLoopSound */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	class UAudioComponent* FireAudioComponent;
 
-	/* Fname for the Reload Montage Section */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	FName ReloadMontageSection;
+	FOnWeaponAmmoChanged AmmoChangedEvent;
 
-	/* True while moving the clip while reloading */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	bool bMovingClip;
+#if WITH_EDITORONLY_DATA
+	/* Properties weapons held before they moved to UWeaponDefinition, only loaded to build a definition from, see AItem::PostLoad */
+	UPROPERTY()
+	int32 MagazineCapacity_DEPRECATED;
 
-	/* Name for the clip bone */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
-	FName ClipBoneName;
+	UPROPERTY()
+	EWeaponType WeaponType_DEPRECATED;
+
+	UPROPERTY()
+	EAmmoType AmmoType_DEPRECATED;
+
+	UPROPERTY()
+	FName ReloadMontageSection_DEPRECATED;
+
+	UPROPERTY()
+	FName ClipBoneName_DEPRECATED;
+#endif
 public:
 	/* Adds an impulse to a weapon */
 	void ThrowWeapon();
 
 	FORCEINLINE int32 GetAmmo() const { return Ammo; }
 
-	FORCEINLINE int32 GetMagazineCapacity() const { return MagazineCapacity; }
+	/* Fired by DecrementAmmo, ReloadAmmo and when a pooled weapon gets its magazine refilled */
+	FORCEINLINE FOnWeaponAmmoChanged& OnAmmoChanged() { return AmmoChangedEvent; }
+
+	/* The weapon definition, or the class default one if the item definition isn't a weapon definition */
+	const UWeaponDefinition* GetWeaponDefinition() const;
+
+	FORCEINLINE int32 GetMagazineCapacity() const { return GetWeaponDefinition()->GetMagazineCapacity(); }
 
 	/* Called from Character class when firing weapon */
 	void DecrementAmmo();
 
-	FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
-	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
-	FORCEINLINE FName GetReloadMontageSection() const { return ReloadMontageSection; }
-	FORCEINLINE FName GetClipBoneName() const { return ClipBoneName; }
+	FORCEINLINE EWeaponType GetWeaponType() const { return GetWeaponDefinition()->GetWeaponType(); }
+	FORCEINLINE EAmmoType GetAmmoType() const { return GetWeaponDefinition()->GetAmmoType(); }
+	FORCEINLINE FName GetReloadMontageSection() const { return GetWeaponDefinition()->GetReloadMontageSection(); }
+	FORCEINLINE FName GetClipBoneName() const { return GetWeaponDefinition()->GetClipBoneName(); }
+
+	/* World transform of the barrel socket, false if the mesh doesn't have one */
+	bool GetBarrelSocketTransform(FTransform& OutTransform);
+
+	/* World transform of the clip bone, false if the mesh doesn't have one */
+	bool GetClipBoneTransform(FTransform& OutTransform);
 
 	void ReloadAmmo(int32 Amount);
 
 	FORCEINLINE void SetMovingClip(bool Move) { bMovingClip = Move; }
 
 	bool ClipIsFull();
+
+	/* True if this type of weapon fires simulated projectiles instead of hitscan beams */
+	FORCEINLINE bool UsesProjectiles() const { return GetWeaponDefinition()->UsesProjectiles(); }
+
+	FORCEINLINE float GetProjectileSpeed() const { return GetWeaponDefinition()->GetProjectileSpeed(); }
+	FORCEINLINE float GetProjectileDrag() const { return GetWeaponDefinition()->GetProjectileDrag(); }
+	FORCEINLINE int32 GetPelletCount() const { return GetWeaponDefinition()->GetPelletCount(); }
+	FORCEINLINE float GetPelletSpread() const { return GetWeaponDefinition()->GetPelletSpread(); }
+	FORCEINLINE float GetDamage() const { return GetWeaponDefinition()->GetDamage(); }
+	FORCEINLINE bool IsAutomatic() const { return GetWeaponDefinition()->IsAutomatic(); }
+
+	/* True if gunfire is a single looping voice rather than a sound per shot. Until the loop has streamed in every shot plays its own sound */
+	FORCEINLINE bool UsesFireLoop() const { return IsAutomatic() && GetWeaponDefinition()->GetFireLoopSound() != nullptr; }
+
+	/* Start the gunfire loop, does nothing if it is already playing */
+	void StartFireLoop();
+
+	/* Stop the gunfire loop and play the tail, does nothing if it isn't playing */
+	void StopFireLoop();
+
+	/* Also stops falling and refills the magazine to the class default */
+	virtual void ResetPooledItem() override;
 };
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponDefinition.h"
+#include "Sound/SoundBase.h"
+
+UWeaponDefinition::UWeaponDefinition() :
+	MagazineCapacity(30),
+	WeaponType(EWeaponType::EWT_SubmachineGun),
+	AmmoType(EAmmoType::EAT_9mm),
+	ReloadMontageSection(FName("Reload SMG")),
+	ClipBoneName("smg_clip"),
+	BarrelSocketName("BarrelSocket"),
+	ProjectileSpeed(40'000.f),
+	ProjectileDrag(0.000001f),
+	PelletCount(1),
+	PelletSpread(0.f),
+	Damage(20.f),
+	bAutomatic(true)
+{
+}
+
+void UWeaponDefinition::GetStreamedAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	Super::GetStreamedAssets(OutAssets);
+
+	OutAssets.Add(FireLoopSound.ToSoftObjectPath());
+	OutAssets.Add(FireTailSound.ToSoftObjectPath());
+}
+
+bool UWeaponDefinition::UsesProjectiles() const
+{
+	switch (WeaponType)
+	{
+	case EWeaponType::EWT_AssaultRifle:
+		// Long range weapon, travel time and drop matter
+		return true;
+	default:
+		return false;
+	}
+}
+
+USoundBase* UWeaponDefinition::GetFireLoopSound() const
+{
+	return FireLoopSound.Get();
+}
+
+USoundBase* UWeaponDefinition::GetFireTailSound() const
+{
+	return FireTailSound.Get();
+}
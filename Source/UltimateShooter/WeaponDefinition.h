@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemDefinition.h"
+#include "AmmoType.h"
+#include "WeaponDefinition.generated.h"
+
+class USoundBase;
+
+UENUM(BlueprintType)
+enum class EWeaponType : uint8
+{
+	EWT_SubmachineGun UMETA(DisplayName = "SubmachineGun"),
+	EWT_AssaultRifle UMETA(DisplayName = "AssaultRifle"),
+	EWT_Shotgun UMETA(DisplayName = "Shotgun"),
+
+	EWT_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * Properties shared by every weapon of one kind, the ammo left in a magazine stays on AWeapon
+ */
+UCLASS(BlueprintType)
+class ULTIMATESHOOTER_API UWeaponDefinition : public UItemDefinition
+{
+	GENERATED_BODY()
+
+	/* Builds definitions from the properties weapons saved before definitions existed, see AWeapon::MigrateDeprecatedProperties */
+	friend class AWeapon;
+
+public:
+	UWeaponDefinition();
+
+	virtual void GetStreamedAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
+	/* True if this type of weapon fires simulated projectiles instead of hitscan beams */
+	bool UsesProjectiles() const;
+
+private:
+	/* Maximum Ammo that our weapon can hold */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	int32 MagazineCapacity;
+
+	/* The type of weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	EWeaponType WeaponType;
+
+	/* Type of ammo for this weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	EAmmoType AmmoType;
+
+	/* Fname for the Reload Montage Section */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	FName ReloadMontageSection;
+
+	/* Name for the clip bone */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	FName ClipBoneName;
+
+	/* Name for the socket bullets leave the barrel from */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	FName BarrelSocketName;
+
+	/* Muzzle velocity of projectile weapons, cm/s */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	float ProjectileSpeed;
+
+	/* Quadratic drag of projectile weapons, deceleration is ProjectileDrag * Speed^2 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	float ProjectileDrag;
+
+	/* Pellets fired per shot, more than one spreads them over a cone */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", ClampMin = "1", ClampMax = "16"))
+	int32 PelletCount;
+
+	/* Half angle of the pellet cone in degrees, scaled by the crosshair spread */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true", ClampMin = "0.0"))
+	float PelletSpread;
+
+	/* Damage dealt by each pellet that hits */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	float Damage;
+
+	/* Keeps firing while the fire button is held. False fires once per press */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	bool bAutomatic;
+
+	/* Looping gunfire for automatic weapons, played for as long as the trigger is held instead of a sound per shot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundBase> FireLoopSound;
+
+	/* Played when the gunfire loop stops */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<USoundBase> FireTailSound;
+public:
+	FORCEINLINE int32 GetMagazineCapacity() const { return MagazineCapacity; }
+	FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
+	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
+	FORCEINLINE FName GetReloadMontageSection() const { return ReloadMontageSection; }
+	FORCEINLINE FName GetClipBoneName() const { return ClipBoneName; }
+	FORCEINLINE FName GetBarrelSocketName() const { return BarrelSocketName; }
+	FORCEINLINE float GetProjectileSpeed() const { return ProjectileSpeed; }
+	FORCEINLINE float GetProjectileDrag() const { return ProjectileDrag; }
+	FORCEINLINE int32 GetPelletCount() const { return PelletCount; }
+	FORCEINLINE float GetPelletSpread() const { return PelletSpread; }
+	FORCEINLINE float GetDamage() const { return Damage; }
+	FORCEINLINE bool IsAutomatic() const { return bAutomatic; }
+
+	/* Streamed assets, null until loaded */
+	USoundBase* GetFireLoopSound() const;
+	USoundBase* GetFireTailSound() const;
+};